@@ -4,93 +4,299 @@
 #include <cstdio>
 #include <sstream>
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <type_traits>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <map>
+#include <set>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-// GLOBAL VARIABLES
+// BOARDS
 
-// board stack (for undo/redo)
-int boardStack[9][9][89];
-int stackIndex = 0;
-int maxIndex = 0;
+// a sudoku board: values stored row by row (0 for empty squares), with the starting squares kept in a
+// separate bitmask so the values themselves are never negative; 104 bytes, so it fits in two cache lines
+struct Board
+{
+	uint8_t cells[81];
+	uint64_t givens[2]; // bit i % 64 of givens[i / 64] is set when square i is a starting square
+};
 
-// file directory 
-int numSaves = 0;
-string* savedGames = NULL;
+// function to get the index of the square in column x and row y
+inline int squareIndex(int x, int y)
+{
+	return y * 9 + x;
+}
 
-// initial board configuration (in case there is no autosave file)
-int board[9][9] =
+// function to check if a square is a starting square
+inline bool isGiven(const Board& board, int square)
 {
-	{-1, 0, 0,-8, 0, 0,-6,-5, 0},
-	{ 0, 0, 0,-9,-1, 0, 0,-2, 0},
-	{ 0,-8, 0, 0,-5, 0,-7, 0,-9},
-	{ 0, 0, 0, 0, 0, 0, 0,-9, 0},
-	{ 0,-5,-3, 0,-4, 0,-1,-7, 0},
-	{ 0,-4, 0, 0, 0, 0, 0, 0, 0},
-	{-5, 0,-2, 0,-9, 0, 0,-3, 0},
-	{ 0,-9, 0, 0,-7,-5, 0, 0, 0},
-	{ 0,-7,-6, 0, 0,-2, 0, 0,-5},
-};
+	return (board.givens[square / 64] >> (square % 64)) & 1;
+}
 
-// function to push a board state onto the stack
-void push(int board[9][9])
+// function to mark or unmark a starting square
+inline void setGiven(Board& board, int square, bool given)
 {
-	for (int x = 0; x < 9; ++x)
-		for (int y = 0; y < 9; ++y)
-			boardStack[x][y][stackIndex] = board[x][y];
-	++stackIndex;
-	maxIndex = stackIndex;
+	uint64_t bit = 1ull << (square % 64);
+	if (given) board.givens[square / 64] |= bit;
+	else board.givens[square / 64] &= ~bit;
 }
 
-// function to clear the console
-void clear()
+// function to empty a board
+inline void clearBoard(Board& board)
 {
-#ifdef _WIN32
-	system("cls"); // windows command to clear the console
-#else
-	system("clear"); // unix command to clear the console
-#endif
+	memset(&board, 0, sizeof(board));
 }
 
-// function to save a game
-bool save(string filename, int board[9][9])
+// function to check if two boards have the same values and starting squares
+inline bool sameBoard(const Board& a, const Board& b)
 {
-	// output file stream object
-	ofstream fout;
+	return memcmp(a.cells, b.cells, sizeof(a.cells)) == 0 && a.givens[0] == b.givens[0] && a.givens[1] == b.givens[1];
+}
 
-	// open a file
-	fout.open(filename);
+// function to get a square as a single signed value (negative for starting squares, as in old save files)
+inline int signedValue(const Board& board, int square)
+{
+	return isGiven(board, square) ? -board.cells[square] : board.cells[square];
+}
 
-	// check for errors
-	if (fout.fail())
+// function to set a square from a signed value (negative for starting squares)
+inline void setSignedValue(Board& board, int square, int value)
+{
+	board.cells[square] = (uint8_t)abs(value);
+	setGiven(board, square, value < 0);
+}
+
+// PACKED BOARDS
+
+// size of a packed board: 4 bits per square, then one bit per square marking the starting squares
+const int PACKED_DIGITS = 41;
+const int PACKED_SIZE = PACKED_DIGITS + 11;
+
+// a board packed into 52 bytes (squares are stored row by row)
+struct PackedBoard
+{
+	unsigned char bytes[PACKED_SIZE];
+};
+
+// function to pack a board
+void packBoard(const Board& board, PackedBoard& packed)
+{
+	for (int i = 0; i < PACKED_SIZE; ++i) packed.bytes[i] = 0;
+
+	for (int i = 0; i < 81; ++i)
 	{
-		fout.close();
-		return false;
+		packed.bytes[i / 2] |= (unsigned char)(board.cells[i] << ((i % 2) * 4));
+		if (isGiven(board, i)) packed.bytes[PACKED_DIGITS + i / 8] |= (unsigned char)(1 << (i % 8));
 	}
+}
 
-	// write the board state to the file
-	for (int y = 0; y < 9; ++y)
+// function to unpack a board (returns false if the packed data is not a valid board)
+bool unpackBoard(const PackedBoard& packed, Board& board)
+{
+	Board temp;
+	clearBoard(temp);
+	for (int i = 0; i < 81; ++i)
 	{
-		for (int x = 0; x < 9; ++x)
+		int value = (packed.bytes[i / 2] >> ((i % 2) * 4)) & 0xF;
+		bool given = (packed.bytes[PACKED_DIGITS + i / 8] >> (i % 8)) & 1;
+		if (value > 9 || (given && value == 0)) return false;
+		temp.cells[i] = (uint8_t)value;
+		setGiven(temp, i, given);
+	}
+	board = temp;
+	return true;
+}
+
+// GLOBAL VARIABLES
+
+// undo/redo history: each step is stored as the list of squares it changed, with a packed
+// snapshot of the board every SNAPSHOT_INTERVAL steps so that any step can be reached quickly
+struct Change
+{
+	unsigned char square; // square index, row by row
+	signed char oldValue; // signed values (negative for starting squares)
+	signed char newValue;
+};
+
+const int SNAPSHOT_INTERVAL = 32;
+
+vector<Change> changes;        // the changes made by every step, in order
+vector<size_t> stepEnds;       // for each step, the index in changes just past its last change
+vector<PackedBoard> snapshots; // board after steps 0, SNAPSHOT_INTERVAL, 2 * SNAPSHOT_INTERVAL, ...
+int historyIndex = 0;          // number of steps currently applied to the board
+Board historyBoard;            // board as of the current step
+
+// initial board configuration, row by row (in case there is no autosave)
+const char* INITIAL_BOARD =
+	"1.....5.."
+	"..8.54.97"
+	"....3.2.6"
+	"89......."
+	".15.4.97."
+	".......52"
+	"6.7.1...."
+	"52.97.3.."
+	"..9.....5";
+
+// the board being played
+Board board;
+
+// function to start a new history with a board as its first state
+void resetHistory(const Board& board)
+{
+	changes.clear();
+	stepEnds.clear();
+	snapshots.assign(1, PackedBoard());
+	packBoard(board, snapshots[0]);
+	historyIndex = 0;
+	historyBoard = board;
+}
+
+// function to record the changes since the last step as a new step (any steps that were undone are discarded)
+void push(const Board& board)
+{
+	// a command that changed nothing is not a step
+	if (sameBoard(board, historyBoard)) return;
+
+	// discard the redo history
+	changes.resize(historyIndex > 0 ? stepEnds[historyIndex - 1] : 0);
+	stepEnds.resize(historyIndex);
+	snapshots.resize(historyIndex / SNAPSHOT_INTERVAL + 1);
+
+	// record every square that changed
+	for (int square = 0; square < 81; ++square)
+	{
+		int oldValue = signedValue(historyBoard, square);
+		int newValue = signedValue(board, square);
+		if (newValue != oldValue)
 		{
-			fout << board[x][y] << " ";
+			Change change;
+			change.square = (unsigned char)square;
+			change.oldValue = (signed char)oldValue;
+			change.newValue = (signed char)newValue;
+			changes.push_back(change);
 		}
-		fout << endl;
 	}
+	historyBoard = board;
 
-	// close file and return
-	fout.close();
-	return true;
+	stepEnds.push_back(changes.size());
+	++historyIndex;
+	if (historyIndex % SNAPSHOT_INTERVAL == 0)
+	{
+		snapshots.push_back(PackedBoard());
+		packBoard(board, snapshots.back());
+	}
+}
+
+// function to move the board to any step in the history
+// close steps are reached by replaying changes, distant ones from the nearest snapshot
+void jumpTo(Board& board, int step)
+{
+	if (step < 0) step = 0;
+	if (step > (int)stepEnds.size()) step = (int)stepEnds.size();
+
+	if (abs(step - historyIndex) > SNAPSHOT_INTERVAL)
+	{
+		unpackBoard(snapshots[step / SNAPSHOT_INTERVAL], historyBoard);
+		historyIndex = step / SNAPSHOT_INTERVAL * SNAPSHOT_INTERVAL;
+	}
+
+	// undo steps
+	while (historyIndex > step)
+	{
+		--historyIndex;
+		size_t first = historyIndex > 0 ? stepEnds[historyIndex - 1] : 0;
+		for (size_t i = stepEnds[historyIndex]; i > first; --i)
+			setSignedValue(historyBoard, changes[i - 1].square, changes[i - 1].oldValue);
+	}
+
+	// redo steps
+	while (historyIndex < step)
+	{
+		size_t first = historyIndex > 0 ? stepEnds[historyIndex - 1] : 0;
+		for (size_t i = first; i < stepEnds[historyIndex]; ++i)
+			setSignedValue(historyBoard, changes[i].square, changes[i].newValue);
+		++historyIndex;
+	}
+
+	board = historyBoard;
+}
+
+// function to clear the console
+void clear()
+{
+#ifdef _WIN32
+	system("cls"); // windows command to clear the console
+#else
+	cout << "\033[2J\033[H" << flush; // ANSI escape to clear the console (no need to start a subprocess)
+#endif
+}
+
+// random number generator state (each thread has its own, so puzzles can be generated in parallel)
+thread_local unsigned long long randomState = 0x9E3779B97F4A7C15ull;
+
+// function to seed the random number generator of the calling thread
+void seedRandom(unsigned long long seed)
+{
+	// scramble the seed (splitmix64) so that nearby seeds give unrelated sequences
+	seed += 0x9E3779B97F4A7C15ull;
+	seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+	seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+	seed ^= seed >> 31;
+	randomState = seed ? seed : 1;
+}
+
+// function to get a random integer from 0 to n - 1 (xorshift64*)
+inline int randomInt(int n)
+{
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+	return (int)(((randomState * 0x2545F4914F6CDD1Dull) >> 32) % (unsigned int)n);
 }
 
-// function to load a game from a file
-bool load(string filename, int board[9][9])
+// marker at the start of a packed save file (older save files are plain text)
+const char SAVE_MAGIC[4] = { 'S', 'D', 'K', 1 };
+
+// function to load a game from a file (games are saved in the save store; this reads the files of older versions)
+bool load(string filename, Board& board)
 {
 	// input file stream object
 	ifstream fin;
 
 	// open a file
-	fin.open(filename);
+	fin.open(filename, ios::binary);
 
 	// check for errors
 	if (fin.fail())
@@ -99,22 +305,67 @@ bool load(string filename, int board[9][9])
 		return false;
 	}
 
-	// read data from the file
-	for (int y = 0; y < 9; ++y)
+	// packed save files start with a marker
+	char magic[sizeof(SAVE_MAGIC)];
+	fin.read(magic, sizeof(magic));
+	if (fin.gcount() == sizeof(magic) && memcmp(magic, SAVE_MAGIC, sizeof(magic)) == 0)
 	{
-		for (int x = 0; x < 9; ++x)
-		{
-			fin >> board[x][y];
-		}
+		PackedBoard packed;
+		fin.read((char*)packed.bytes, PACKED_SIZE);
+		bool loaded = fin.gcount() == PACKED_SIZE && unpackBoard(packed, board);
+		fin.close();
+		return loaded;
+	}
+
+	// otherwise, read the old text format (81 numbers, row by row)
+	fin.clear();
+	fin.seekg(0);
+	Board temp;
+	clearBoard(temp);
+	for (int square = 0; square < 81; ++square)
+	{
+		int value = 0;
+		fin >> value;
+		setSignedValue(temp, square, value);
 	}
 
+	// only replace the board if the whole file was read
+	bool loaded = !fin.fail();
+	if (loaded) board = temp;
+
 	// close file and return
 	fin.close();
+	return loaded;
+}
+
+// function to write a board as a single 81 character line (rows in order, '.' for empty squares)
+string toLine(const Board& board)
+{
+	string line(81, '.');
+	for (int square = 0; square < 81; ++square)
+		if (board.cells[square] != 0) line[square] = char('0' + board.cells[square]);
+	return line;
+}
+
+// function to read a board from an 81 character line ('0' or '.' for empty squares)
+// filled squares become starting squares; returns false if the line is malformed
+bool fromLine(const char* line, int length, Board& board)
+{
+	if (length < 81) return false;
+	clearBoard(board);
+	for (int i = 0; i < 81; ++i)
+	{
+		char c = line[i];
+		if (c == '.' || c == '0') continue;
+		if (c < '1' || c > '9') return false;
+		board.cells[i] = (uint8_t)(c - '0');
+		setGiven(board, i, true);
+	}
 	return true;
 }
 
 // function to draw a sudoku board in the console
-void draw(int board[9][9])
+void draw(const Board& board)
 {
 	// set text color to gray
 	cout << "\033[38;2;150;150;150m";
@@ -141,13 +392,14 @@ void draw(int board[9][9])
 			if (x == 3 || x == 6) cout << "\033[38;2;150;150;150m| ";
 
 			// if the number is a starting number, change the text color to green
-			if (board[x][y] < 0) cout << "\033[38;2;0;255;0m";
+			int square = squareIndex(x, y);
+			if (isGiven(board, square)) cout << "\033[38;2;0;255;0m";
 
 			// otherwise, restore default settings
 			else cout << "\033[0m";
 
 			// print the number
-			if (board[x][y] != 0) cout << abs(board[x][y]) << " ";
+			if (board.cells[square] != 0) cout << (int)board.cells[square] << " ";
 			else cout << "  ";
 		}
 
@@ -159,9 +411,141 @@ void draw(int board[9][9])
 	cout << "\033[0m";
 }
 
+// SEARCH STATISTICS
+
+// phases of work that are timed separately
+enum Phase
+{
+	PHASE_SOLVE,    // solve()
+	PHASE_COUNT,    // multiSolve() and countSolutions()
+	PHASE_FILL,     // randFill()
+	PHASE_GENERATE, // generate()
+	NUM_PHASES
+};
+
+// counters kept by the searches; nodes are always counted, everything else only when
+// the program is built with -DSUDOKU_STATS (otherwise the STAT() statements compile to nothing)
+struct SearchStats
+{
+	long long nodes;            // values placed while branching
+	long long backtracks;       // branches that led to no solution
+	long long legalChecks;      // isLegal() calls
+	long long uniquenessChecks; // uniqueness checks made by generate()
+	long long generateCalls;    // top level generate() calls
+	int depth;                  // current recursion depth
+	int maxDepth;               // deepest recursion seen
+	long long phaseCalls[NUM_PHASES];
+	double phaseMicros[NUM_PHASES];
+	bool phaseActive[NUM_PHASES];
+};
+
+#ifdef SUDOKU_STATS
+#define STAT(statement) statement
+#else
+#define STAT(statement)
+#endif
+
+// statistics of the calling thread
+thread_local SearchStats stats = {};
+
+// statistics of pool worker threads that have finished (added in when each worker exits)
+SearchStats workerStats = {};
+mutex workerStatsLock;
+
+// function to add one set of statistics to another
+void addStats(SearchStats& total, const SearchStats& more)
+{
+	total.nodes += more.nodes;
+	total.backtracks += more.backtracks;
+	total.legalChecks += more.legalChecks;
+	total.uniquenessChecks += more.uniquenessChecks;
+	total.generateCalls += more.generateCalls;
+	if (more.maxDepth > total.maxDepth) total.maxDepth = more.maxDepth;
+	for (int i = 0; i < NUM_PHASES; ++i)
+	{
+		total.phaseCalls[i] += more.phaseCalls[i];
+		total.phaseMicros[i] += more.phaseMicros[i];
+	}
+}
+
+// function to get the statistics of this thread together with those of every finished worker
+SearchStats currentStats()
+{
+	SearchStats total = stats;
+	lock_guard<mutex> guard(workerStatsLock);
+	addStats(total, workerStats);
+	return total;
+}
+
+// function to clear the statistics of this thread and of the finished workers
+void resetStats()
+{
+	stats = SearchStats();
+	lock_guard<mutex> guard(workerStatsLock);
+	workerStats = SearchStats();
+}
+
+// function to write the statistics in a readable form
+void printStats(ostream& out, const SearchStats& s)
+{
+	out << "Nodes expanded: " << s.nodes << endl;
+#ifdef SUDOKU_STATS
+	const char* phaseNames[NUM_PHASES] = { "solve", "count", "randFill", "generate" };
+
+	out << "Backtracks: " << s.backtracks << endl;
+	out << "isLegal calls: " << s.legalChecks << endl;
+	out << "Max recursion depth: " << s.maxDepth << endl;
+	out << "Uniqueness checks: " << s.uniquenessChecks;
+	if (s.generateCalls > 0) out << " (" << (double)s.uniquenessChecks / s.generateCalls << " per generate)";
+	out << endl;
+	for (int i = 0; i < NUM_PHASES; ++i)
+		if (s.phaseCalls[i] > 0)
+			out << "Time in " << phaseNames[i] << ": " << s.phaseMicros[i] / 1000 << " ms over " << s.phaseCalls[i] << " calls" << endl;
+#else
+	out << "(build with -DSUDOKU_STATS for backtracks, isLegal calls, depth, uniqueness checks and phase timings)" << endl;
+#endif
+}
+
+// tracks the recursion depth of a search function for as long as it is in scope
+struct DepthGuard
+{
+	DepthGuard()
+	{
+		if (++stats.depth > stats.maxDepth) stats.maxDepth = stats.depth;
+	}
+	~DepthGuard()
+	{
+		--stats.depth;
+	}
+};
+
+// times a phase for as long as it is in scope (nested calls of the same phase are only timed once)
+struct PhaseTimer
+{
+	Phase phase;
+	bool outermost;
+	chrono::steady_clock::time_point start;
+
+	PhaseTimer(Phase p) : phase(p), outermost(!stats.phaseActive[p])
+	{
+		if (!outermost) return;
+		stats.phaseActive[phase] = true;
+		++stats.phaseCalls[phase];
+		start = chrono::steady_clock::now();
+	}
+	~PhaseTimer()
+	{
+		if (!outermost) return;
+		stats.phaseMicros[phase] += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+		stats.phaseActive[phase] = false;
+	}
+};
+
 // function to check if a move is legal
-bool isLegal(int board[9][9], int x, int y, int value) // arguments go in the parentheses
+bool isLegal(const Board& board, int x, int y, int value) // arguments go in the parentheses
 {
+	STAT(++stats.legalChecks);
+
 	// check to make sure we are on the board
 	if (x < 0 || x >= 9 || y < 0 || y >= 9) return false;
 
@@ -172,231 +556,4181 @@ bool isLegal(int board[9][9], int x, int y, int value) // arguments go in the pa
 	if (value == 0) return true;
 
 	// make it illegal to modify starting squares
-	if (board[x][y] < 0) return false;
+	int square = squareIndex(x, y);
+	if (isGiven(board, square)) return false;
 
 	// check row and column
-	for (int x = 0; x < 9; ++x)
-		if (abs(board[x][y]) == value) return false;
-	
-	for (int y = 0; y < 9; ++y)
-		if (abs(board[x][y]) == value) return false;
+	for (int i = 0; i < 9; ++i)
+		if (board.cells[squareIndex(i, y)] == value || board.cells[squareIndex(x, i)] == value) return false;
 
 	// check subgrid
 	int subgrid_x = (x / 3) * 3;
 	int subgrid_y = (y / 3) * 3;
 
-	for (int x = subgrid_x; x < subgrid_x + 3; ++x)
-		for (int y = subgrid_y; y < subgrid_y + 3; ++y)
-			if (abs(board[x][y]) == value) return false;
+	for (int y = subgrid_y; y < subgrid_y + 3; ++y)
+		for (int x = subgrid_x; x < subgrid_x + 3; ++x)
+			if (board.cells[squareIndex(x, y)] == value) return false;
 
 	// if the move is not illegal, then it is legal
 	return true;
 }
 
-// function to solve a sudoku board
-bool solve(int board[9][9])
+// function to count the number of set bits in a candidate mask
+inline int bitCount(unsigned int mask)
 {
-	// find an empty square
-	for (int x = 0; x < 9; ++x)
-		for (int y = 0; y < 9; ++y)
-			if (board[x][y] == 0)
-			{
-				// loop through all legal values for the square
-				for (int i = 1; i <= 9; ++i)
-					if (isLegal(board, x, y, i))
-					{
-						board[x][y] = i;
+#ifdef _MSC_VER
+	return __popcnt(mask);
+#else
+	return __builtin_popcount(mask);
+#endif
+}
 
-						// check to see if we have found the right value by recursively calling solve
-						if (solve(board)) return true;
-					}
+// function to find the index of the lowest set bit in a (non-zero) candidate mask
+inline int lowestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
 
-				// if we can't find a value for the square, then backtrack
-				board[x][y] = 0;
-				return false;
-			}
+// all nine values are used
+const unsigned int ALL_VALUES = 0x1FF;
 
-	// if there are no empty sqauares, then the board is solved
-	return true;
-}
+// occupancy masks for the bitmask solver (bit value - 1 is set when value is used)
+struct Masks
+{
+	unsigned int rows[9];
+	unsigned int cols[9];
+	unsigned int boxes[9];
+};
 
-// function to fill a board with random valid values
-bool randFill(int board[9][9])
+// function to get the index of the subgrid containing a square
+inline int boxIndex(int x, int y)
 {
-	// find an empty square
-	for (int x = 0; x < 9; ++x)
-		for (int y = 0; y < 9; ++y)
-			if (board[x][y] == 0)
-			{
-				int values[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
-				int numValues = 9;
+	return (y / 3) * 3 + x / 3;
+}
 
-				// try values in a random order
-				while (numValues)
-				{
-					// randomly choose a value
-					int index = rand() % numValues;
-					int value = values[index];
+// function to get the mask of values that can legally be placed in a square
+inline unsigned int candidates(const Masks& masks, int x, int y)
+{
+	return ~(masks.rows[y] | masks.cols[x] | masks.boxes[boxIndex(x, y)]) & ALL_VALUES;
+}
 
-					// remove the chosen value from the array
-					--numValues;
-					for (int i = index; i < numValues; ++i)
-						values[i] = values[i + 1];
+// function to place or remove a value (toggles its bit in the row, column and subgrid)
+inline void toggle(Masks& masks, int x, int y, unsigned int bit)
+{
+	masks.rows[y] ^= bit;
+	masks.cols[x] ^= bit;
+	masks.boxes[boxIndex(x, y)] ^= bit;
+}
 
-					// if the value is legal, then try it and recurse
-					if (isLegal(board, x, y, value))
-					{
-						board[x][y] = value;
-						if (randFill(board)) return true;
-					}
-				}
+// SIMD KERNELS
+//
+// the row, column and subgrid masks of a board are computed a whole row of squares at a time: a byte
+// shuffle turns each square into the bit of its value, ORing rows together gives the column and subgrid
+// masks, and ORing neighbouring lanes gives the row masks. a byte only has room for values 1 to 8, so
+// 9s are tracked separately with a compare. the AVX2 kernel works on two rows per instruction.
+// the kernel is picked once at startup from what the CPU supports, with a scalar fallback.
 
-				// if no values were found, then backtrack
-				board[x][y] = 0;
-				return false;
-			}
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_KERNELS 1
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define SIMD_KERNELS 1
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_KERNELS 0
+#endif
 
-	// if no squares are empty, then we are done
-	return true;
-}
+// code shared by kernels built for different instruction sets has to be inlined into each of them
+#if defined(_MSC_VER)
+#define FORCE_INLINE __forceinline
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
+#endif
 
-// function to detect if a board has multiple solutions
-bool multiSolve(int board[9][9], int& numSolutions)
+// function to compute the row, column and subgrid masks of 81 squares stored row by row
+// a square holding base + v (v from 1 to 9) has value v; anything else counts as empty
+void unitMasksScalar(const uint8_t* squares, uint8_t base, Masks& masks)
 {
-	// find an empty square
-	for (int x = 0; x < 9; ++x)
-		for (int y = 0; y < 9; ++y)
-			if (board[x][y] == 0)
-			{
-				// loop through all legal values for the square
-				for (int i = 1; i <= 9; ++i)
-					if (isLegal(board, x, y, i))
-					{
-						board[x][y] = i;
+	for (int i = 0; i < 9; ++i)
+		masks.rows[i] = masks.cols[i] = masks.boxes[i] = 0;
 
-						// recursive call
-						if (multiSolve(board, numSolutions)) return true;
-					}
+	for (int square = 0; square < 81; ++square)
+	{
+		int value = squares[square] - base;
+		if (value < 1 || value > 9) continue;
 
-				// backtrack
-				board[x][y] = 0;
-				return false;
-			}
+		int x = square % 9, y = square / 9;
+		unsigned int bit = 1u << (value - 1);
+		masks.rows[y] |= bit;
+		masks.cols[x] |= bit;
+		masks.boxes[boxIndex(x, y)] |= bit;
+	}
+}
 
-	// if the board is full, increment solution counter and return
-	++numSolutions;
-	return numSolutions >= 2;
+#if SIMD_KERNELS
+// function to load a row of squares into the first 9 lanes of a vector
+// (the last row is loaded from 7 bytes earlier and shifted, so no load reaches past the 81 squares)
+SIMD_TARGET("sse4.1")
+inline __m128i loadRow(const uint8_t* squares, int y)
+{
+	if (y < 8) return _mm_loadu_si128((const __m128i*)(squares + y * 9));
+	return _mm_srli_si128(_mm_loadu_si128((const __m128i*)(squares + 65)), 7);
 }
 
-// function to reduce a full board while ensuring solution uniqueness
-bool generate(int board[9][9], int numEntries)
+// function to turn the squares of a row into value indices (0 to 8), with the high bit set for empty
+// squares and for the lanes past the end of the row (so that a byte shuffle maps them to 0)
+SIMD_TARGET("sse4.1")
+inline __m128i valueIndices(__m128i row, uint8_t base)
 {
-	// if there are multiple solutions, then backtrack
-	int tempBoard[9][9];
-	for (int x = 0; x < 9; ++x)
-		for (int y = 0; y < 9; ++y)
-			tempBoard[x][y] = board[x][y];
+	const __m128i ROW_LANES = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0);
+	__m128i index = _mm_sub_epi8(row, _mm_set1_epi8((char)(base + 1)));
+	__m128i valid = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(index, _mm_set1_epi8(8)), index), ROW_LANES);
+	return _mm_or_si128(index, _mm_andnot_si128(valid, _mm_set1_epi8(-128)));
+}
 
-	int numSolutions = 0;
-	if (multiSolve(tempBoard, numSolutions)) return 0;
+// function to compute the unit masks with SSE4.1, one row at a time
+SIMD_TARGET("sse4.1")
+void unitMasksSSE41(const uint8_t* squares, uint8_t base, Masks& masks)
+{
+	// bit for each value index; index 8 (value 9) is handled by the compare below
+	const __m128i VALUE_BITS = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i NINE = _mm_set1_epi8(8);
 
-	// make a list of all non-empty squares
-	int xList[81];
-	int yList[81];
-	int numNonEmpties = 0;
+	__m128i colBits = _mm_setzero_si128(), colNines = _mm_setzero_si128();
+	__m128i bandBits = _mm_setzero_si128(), bandNines = _mm_setzero_si128();
+	for (int y = 0; y < 9; ++y)
+	{
+		__m128i index = valueIndices(loadRow(squares, y), base);
+		__m128i bits = _mm_shuffle_epi8(VALUE_BITS, index);
+		__m128i nines = _mm_cmpeq_epi8(index, NINE);
 
-	for (int x = 0; x < 9; ++x)
-		for (int y = 0; y < 9; ++y)
-			if (board[x][y] != 0)
-			{
-				xList[numNonEmpties] = x;
-				yList[numNonEmpties] = y;
-				++numNonEmpties;
-			}
+		// OR the 9 lanes of the row together (lanes 0, 3 and 6 first, then lane 0)
+		__m128i triples = _mm_or_si128(bits, _mm_or_si128(_mm_srli_si128(bits, 1), _mm_srli_si128(bits, 2)));
+		__m128i row = _mm_or_si128(triples, _mm_or_si128(_mm_srli_si128(triples, 3), _mm_srli_si128(triples, 6)));
+		masks.rows[y] = (_mm_cvtsi128_si32(row) & 0xFF) | (_mm_movemask_epi8(nines) ? 0x100 : 0);
 
-	// if we have removed enough entries, the we were done
-	if (numNonEmpties <= numEntries) return true;
+		colBits = _mm_or_si128(colBits, bits);
+		colNines = _mm_or_si128(colNines, nines);
+		bandBits = _mm_or_si128(bandBits, bits);
+		bandNines = _mm_or_si128(bandNines, nines);
 
-	// iterate through all non-empty squares
-	while (numNonEmpties)
-	{
-		// pick a random non-empty square
-		int index = rand() % numNonEmpties;
-		int x = xList[index];
-		int y = yList[index];
+		// every third row completes a band of three subgrids
+		if (y % 3 == 2)
+		{
+			triples = _mm_or_si128(bandBits, _mm_or_si128(_mm_srli_si128(bandBits, 1), _mm_srli_si128(bandBits, 2)));
+			int nineLanes = _mm_movemask_epi8(bandNines);
+			masks.boxes[y - 2] = _mm_extract_epi8(triples, 0) | (nineLanes & 0x007 ? 0x100 : 0);
+			masks.boxes[y - 1] = _mm_extract_epi8(triples, 3) | (nineLanes & 0x038 ? 0x100 : 0);
+			masks.boxes[y] = _mm_extract_epi8(triples, 6) | (nineLanes & 0x1C0 ? 0x100 : 0);
+			bandBits = bandNines = _mm_setzero_si128();
+		}
+	}
+
+	alignas(16) uint8_t cols[16];
+	_mm_store_si128((__m128i*)cols, colBits);
+	int nineCols = _mm_movemask_epi8(colNines);
+	for (int x = 0; x < 9; ++x)
+		masks.cols[x] = cols[x] | ((nineCols >> x) & 1) << 8;
+}
+
+// function to compute the unit masks with AVX2, two rows at a time
+// rows are paired (0, 3), (1, 4), (2, 5), (6, 7) and (8, none), so the first three pairs hold the first
+// band in their low halves and the second band in their high halves
+SIMD_TARGET("avx2")
+void unitMasksAVX2(const uint8_t* squares, uint8_t base, Masks& masks)
+{
+	const __m256i VALUE_BITS = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+		1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i NINE = _mm256_set1_epi8(8);
+	const int FIRST[5] = { 0, 1, 2, 6, 8 };
+	const int SECOND[5] = { 3, 4, 5, 7, -1 };
+
+	__m256i pairBits[5], pairNines[5];
+	for (int p = 0; p < 5; ++p)
+	{
+		__m128i first = valueIndices(loadRow(squares, FIRST[p]), base);
+		__m128i second = SECOND[p] >= 0 ? valueIndices(loadRow(squares, SECOND[p]), base) : _mm_set1_epi8(-128);
+		__m256i index = _mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1);
+		__m256i bits = _mm256_shuffle_epi8(VALUE_BITS, index);
+		__m256i nines = _mm256_cmpeq_epi8(index, NINE);
+		pairBits[p] = bits;
+		pairNines[p] = nines;
+
+		// OR the lanes of both rows together (byte shifts stay within each half)
+		__m256i triples = _mm256_or_si256(bits, _mm256_or_si256(_mm256_srli_si256(bits, 1), _mm256_srli_si256(bits, 2)));
+		__m256i rows = _mm256_or_si256(triples, _mm256_or_si256(_mm256_srli_si256(triples, 3), _mm256_srli_si256(triples, 6)));
+		unsigned int nineLanes = (unsigned int)_mm256_movemask_epi8(nines);
+		masks.rows[FIRST[p]] = (unsigned int)_mm256_extract_epi8(rows, 0) | (nineLanes & 0xFFFF ? 0x100 : 0);
+		if (SECOND[p] >= 0) masks.rows[SECOND[p]] = (unsigned int)_mm256_extract_epi8(rows, 16) | (nineLanes >> 16 ? 0x100 : 0);
+	}
+
+	// the first two bands, then the third (split across the last two pairs)
+	__m256i bands = _mm256_or_si256(pairBits[0], _mm256_or_si256(pairBits[1], pairBits[2]));
+	__m256i bandNines = _mm256_or_si256(pairNines[0], _mm256_or_si256(pairNines[1], pairNines[2]));
+	__m128i lastBand = _mm_or_si128(_mm256_castsi256_si128(pairBits[3]), _mm_or_si128(_mm256_extracti128_si256(pairBits[3], 1), _mm256_castsi256_si128(pairBits[4])));
+	__m128i lastNines = _mm_or_si128(_mm256_castsi256_si128(pairNines[3]), _mm_or_si128(_mm256_extracti128_si256(pairNines[3], 1), _mm256_castsi256_si128(pairNines[4])));
+
+	__m256i triples = _mm256_or_si256(bands, _mm256_or_si256(_mm256_srli_si256(bands, 1), _mm256_srli_si256(bands, 2)));
+	__m128i lastTriples = _mm_or_si128(lastBand, _mm_or_si128(_mm_srli_si128(lastBand, 1), _mm_srli_si128(lastBand, 2)));
+	unsigned int nineLanes = (unsigned int)_mm256_movemask_epi8(bandNines);
+	unsigned int lastNineLanes = (unsigned int)_mm_movemask_epi8(lastNines);
+
+	alignas(32) uint8_t boxBits[32];
+	alignas(16) uint8_t lastBoxBits[16];
+	_mm256_store_si256((__m256i*)boxBits, triples);
+	_mm_store_si128((__m128i*)lastBoxBits, lastTriples);
+	for (int i = 0; i < 3; ++i)
+	{
+		masks.boxes[i] = boxBits[i * 3] | ((nineLanes >> (i * 3)) & 7 ? 0x100 : 0);
+		masks.boxes[3 + i] = boxBits[16 + i * 3] | ((nineLanes >> (16 + i * 3)) & 7 ? 0x100 : 0);
+		masks.boxes[6 + i] = lastBoxBits[i * 3] | ((lastNineLanes >> (i * 3)) & 7 ? 0x100 : 0);
+	}
+
+	// every half of every pair ORed together gives the columns
+	__m128i cols = _mm_or_si128(_mm256_castsi256_si128(bands), _mm256_extracti128_si256(bands, 1));
+	cols = _mm_or_si128(cols, lastBand);
+	__m128i colNines = _mm_or_si128(_mm256_castsi256_si128(bandNines), _mm256_extracti128_si256(bandNines, 1));
+	colNines = _mm_or_si128(colNines, lastNines);
+
+	alignas(16) uint8_t colBits[16];
+	_mm_store_si128((__m128i*)colBits, cols);
+	int nineCols = _mm_movemask_epi8(colNines);
+	for (int x = 0; x < 9; ++x)
+		masks.cols[x] = colBits[x] | ((nineCols >> x) & 1) << 8;
+}
+#endif
+
+// functions to check which instruction sets the CPU supports
+bool hasSSE41()
+{
+#if !SIMD_KERNELS
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] >> 19) & 1;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+bool hasAVX2()
+{
+#if !SIMD_KERNELS
+	return false;
+#elif defined(_MSC_VER)
+	// AVX2 also needs the operating system to save the AVX registers
+	int info[4];
+	__cpuid(info, 1);
+	bool osSaves = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1) && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSaves && ((info[1] >> 5) & 1);
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool hasScalar()
+{
+	return true;
+}
+
+// an implementation of the unit mask computation, with a check for whether the CPU can run it
+struct MaskKernel
+{
+	const char* name;
+	void (*unitMasks)(const uint8_t* squares, uint8_t base, Masks& masks);
+	bool (*supported)();
+};
+
+// kernels in order of preference
+const MaskKernel MASK_KERNELS[] =
+{
+#if SIMD_KERNELS
+	{ "avx2", unitMasksAVX2, hasAVX2 },
+	{ "sse4.1", unitMasksSSE41, hasSSE41 },
+#endif
+	{ "scalar", unitMasksScalar, hasScalar },
+};
+
+// function to pick the fastest kernel the CPU supports
+const MaskKernel* chooseMaskKernel()
+{
+	for (const MaskKernel& kernel : MASK_KERNELS)
+		if (kernel.supported()) return &kernel;
+	return NULL;
+}
+
+// kernel used by buildMasks() and isSolvedLine()
+const MaskKernel* maskKernel = chooseMaskKernel();
+
+// function to build the occupancy masks for a board
+void buildMasks(const Board& board, Masks& masks)
+{
+	maskKernel->unitMasks(board.cells, 0, masks);
+}
+
+// function to compute the candidate mask of every square of a board (0 for filled squares)
+void allCandidates(const Board& board, uint16_t candidates[81])
+{
+	Masks masks;
+	buildMasks(board, masks);
+	for (int square = 0; square < 81; ++square)
+	{
+		int x = square % 9, y = square / 9;
+		unsigned int free = ~(masks.rows[y] | masks.cols[x] | masks.boxes[boxIndex(x, y)]) & ALL_VALUES;
+		candidates[square] = (uint16_t)(board.cells[square] == 0 ? free : 0);
+	}
+}
+
+// search strategies that can be selected at runtime
+enum Strategy
+{
+	NAIVE,   // first empty square, every value checked with isLegal()
+	BITMASK, // first empty square, candidates taken from incrementally updated masks
+	MRV,     // most constrained square, with naked and hidden single propagation
+	DANCING_LINKS // exact cover with Algorithm X
+};
+
+// strategy used by solve(), multiSolve() and randFill()
+Strategy strategy = MRV;
+
+// number of threads solve() and multiSolve() split the MRV search across
+int solverThreads = 1;
+
+// function to get the name of a search strategy
+string strategyName(Strategy s)
+{
+	if (s == NAIVE) return "naive";
+	if (s == BITMASK) return "bitmask";
+	if (s == DANCING_LINKS) return "dlx";
+	return "mrv";
+}
+
+// function to solve a sudoku board by trying every value in the first empty square
+bool solveNaive(Board& board)
+{
+	STAT(DepthGuard depth);
+
+	// find an empty square
+	for (int x = 0; x < 9; ++x)
+		for (int y = 0; y < 9; ++y)
+			if (board.cells[squareIndex(x, y)] == 0)
+			{
+				// loop through all legal values for the square
+				for (int i = 1; i <= 9; ++i)
+					if (isLegal(board, x, y, i))
+					{
+						board.cells[squareIndex(x, y)] = (uint8_t)i;
+						++stats.nodes;
+
+						// check to see if we have found the right value by recursively calling solve
+						if (solveNaive(board)) return true;
+					}
+
+				// if we can't find a value for the square, then backtrack
+				board.cells[squareIndex(x, y)] = 0;
+				STAT(++stats.backtracks);
+				return false;
+			}
+
+	// if there are no empty sqauares, then the board is solved
+	return true;
+}
+
+// function to make a list of all empty squares (in the order the naive solver scans them)
+int emptyCells(const Board& board, int cells[81])
+{
+	int numCells = 0;
+	for (int x = 0; x < 9; ++x)
+		for (int y = 0; y < 9; ++y)
+			if (board.cells[squareIndex(x, y)] == 0) cells[numCells++] = squareIndex(x, y);
+	return numCells;
+}
+
+// function to solve the empty squares in a list, starting at a given position in the list
+bool solveCells(Board& board, Masks& masks, const int cells[], int index, int numCells)
+{
+	STAT(DepthGuard depth);
+
+	// if there are no empty squares left, then the board is solved
+	if (index == numCells) return true;
+
+	int square = cells[index];
+	int x = square % 9;
+	int y = square / 9;
+
+	// loop through all legal values for the square (lowest value first)
+	unsigned int free = candidates(masks, x, y);
+	while (free)
+	{
+		unsigned int bit = free & (0u - free);
+		free ^= bit;
+
+		board.cells[square] = (uint8_t)(lowestBit(bit) + 1);
+		toggle(masks, x, y, bit);
+		++stats.nodes;
+
+		// check to see if we have found the right value by recursively solving the remaining squares
+		if (solveCells(board, masks, cells, index + 1, numCells)) return true;
+
+		toggle(masks, x, y, bit);
+	}
+
+	// if we can't find a value for the square, then backtrack
+	board.cells[square] = 0;
+	STAT(++stats.backtracks);
+	return false;
+}
+
+// function to count the solutions of the empty squares in a list (stops once two are found)
+bool multiSolveCells(Board& board, Masks& masks, const int cells[], int index, int numCells, int& numSolutions)
+{
+	STAT(DepthGuard depth);
+
+	// if the board is full, increment solution counter and return
+	if (index == numCells)
+	{
+		++numSolutions;
+		return numSolutions >= 2;
+	}
+
+	int square = cells[index];
+	int x = square % 9;
+	int y = square / 9;
+
+	// loop through all legal values for the square
+	unsigned int free = candidates(masks, x, y);
+	while (free)
+	{
+		unsigned int bit = free & (0u - free);
+		free ^= bit;
+
+		board.cells[square] = (uint8_t)(lowestBit(bit) + 1);
+		toggle(masks, x, y, bit);
+		++stats.nodes;
+
+		// recursive call
+		if (multiSolveCells(board, masks, cells, index + 1, numCells, numSolutions)) return true;
+
+		toggle(masks, x, y, bit);
+	}
+
+	// backtrack
+	board.cells[square] = 0;
+	STAT(++stats.backtracks);
+	return false;
+}
+
+// function to fill the empty squares in a list with random valid values
+bool randFillCells(Board& board, Masks& masks, const int cells[], int index, int numCells)
+{
+	STAT(DepthGuard depth);
+
+	// if no squares are empty, then we are done
+	if (index == numCells) return true;
+
+	int square = cells[index];
+	int x = square % 9;
+	int y = square / 9;
+
+	// try the legal values in a random order
+	unsigned int free = candidates(masks, x, y);
+	while (free)
+	{
+		// randomly choose one of the remaining values
+		int skip = randomInt(bitCount(free));
+		unsigned int rest = free;
+		while (skip--) rest &= rest - 1;
+		unsigned int bit = rest & (0u - rest);
+		free ^= bit;
+
+		board.cells[square] = (uint8_t)(lowestBit(bit) + 1);
+		toggle(masks, x, y, bit);
+		++stats.nodes;
+
+		if (randFillCells(board, masks, cells, index + 1, numCells)) return true;
+
+		toggle(masks, x, y, bit);
+	}
+
+	// if no values were found, then backtrack
+	board.cells[square] = 0;
+	STAT(++stats.backtracks);
+	return false;
+}
+
+// sizes of a board made of N x N subgrids (N = 3 for the standard 9x9 board)
+template <int N>
+struct BoardSize
+{
+	static const int SIDE = N * N;        // squares in each row, column and subgrid (and number of values)
+	static const int CELLS = SIDE * SIDE; // squares on the board
+	static const int UNITS = 3 * SIDE;    // rows, columns and subgrids
+
+	// candidate masks use the smallest word with one bit per value
+	typedef typename conditional<SIDE <= 16, uint16_t, uint32_t>::type Mask;
+	static constexpr Mask ALL = (Mask)((1ull << SIDE) - 1);
+};
+
+// board state used by the MRV solver (copied at every branch instead of undoing propagation)
+template <int N>
+struct Grid
+{
+	typedef BoardSize<N> Size;
+	typedef typename Size::Mask Mask;
+
+	unsigned char cells[Size::CELLS]; // values row by row, 0 for empty squares
+	Mask rows[Size::SIDE];            // bit value - 1 is set when value is used
+	Mask cols[Size::SIDE];
+	Mask boxes[Size::SIDE];
+	int numEmpty;
+};
+
+// the standard board
+typedef Grid<3> SearchState;
+
+// function to get the subgrid containing a square
+template <int N>
+inline int gridBox(int x, int y)
+{
+	return (y / N) * N + x / N;
+}
+
+// function to get the i-th square of a unit (units 0 to SIDE - 1 are rows, then columns, then subgrids)
+template <int N>
+inline int unitSquare(int unit, int i)
+{
+	const int SIDE = N * N;
+	if (unit < SIDE) return unit * SIDE + i;
+	if (unit < 2 * SIDE) return i * SIDE + unit - SIDE;
+	int box = unit - 2 * SIDE;
+	return ((box / N) * N + i / N) * SIDE + (box % N) * N + i % N;
+}
+
+// function to get the mask of values that can legally be placed in a square
+template <int N>
+inline typename Grid<N>::Mask candidates(const Grid<N>& grid, int square)
+{
+	const int SIDE = N * N;
+	int x = square % SIDE, y = square / SIDE;
+	return (typename Grid<N>::Mask)(~(grid.rows[y] | grid.cols[x] | grid.boxes[gridBox<N>(x, y)]) & BoardSize<N>::ALL);
+}
+
+// function to place a value (given as its bit) in an empty square
+template <int N>
+inline void place(Grid<N>& grid, int square, unsigned int bit)
+{
+	const int SIDE = N * N;
+	int x = square % SIDE, y = square / SIDE;
+	grid.cells[square] = (unsigned char)(lowestBit(bit) + 1);
+	grid.rows[y] |= bit;
+	grid.cols[x] |= bit;
+	grid.boxes[gridBox<N>(x, y)] |= bit;
+	--grid.numEmpty;
+}
+
+// function to empty a filled square
+template <int N>
+inline void unplace(Grid<N>& grid, int square)
+{
+	const int SIDE = N * N;
+	int x = square % SIDE, y = square / SIDE;
+	unsigned int bit = 1u << (grid.cells[square] - 1);
+	grid.cells[square] = 0;
+	grid.rows[y] &= ~bit;
+	grid.cols[x] &= ~bit;
+	grid.boxes[gridBox<N>(x, y)] &= ~bit;
+	++grid.numEmpty;
+}
+
+// function to set up a grid from a list of values (row by row, 0 for empty squares)
+// returns false if a value is out of range or two squares in the same unit hold the same value
+template <int N>
+bool initGrid(Grid<N>& grid, const unsigned char values[])
+{
+	const int SIDE = N * N;
+	for (int i = 0; i < SIDE; ++i) grid.rows[i] = grid.cols[i] = grid.boxes[i] = 0;
+	grid.numEmpty = BoardSize<N>::CELLS;
+
+	for (int square = 0; square < BoardSize<N>::CELLS; ++square)
+	{
+		grid.cells[square] = 0;
+		if (values[square] == 0) continue;
+		if (values[square] > SIDE) return false;
+
+		unsigned int bit = 1u << (values[square] - 1);
+		if (!(candidates(grid, square) & bit)) return false;
+		place(grid, square, bit);
+	}
+	return true;
+}
+
+// function to fill in naked singles and hidden singles until no more can be found
+// returns false if the board turns out to be unsolvable
+template <int N>
+bool propagate(Grid<N>& grid)
+{
+	typedef BoardSize<N> Size;
+	typedef typename Size::Mask Mask;
+
+	bool changed = true;
+	while (changed && grid.numEmpty)
+	{
+		changed = false;
+
+		// naked singles: squares with only one candidate
+		for (int square = 0; square < Size::CELLS; ++square)
+			if (grid.cells[square] == 0)
+			{
+				Mask free = candidates(grid, square);
+				if (!free) return false;
+				if (!(free & (free - 1)))
+				{
+					place(grid, square, free);
+					changed = true;
+				}
+			}
+
+		// hidden singles: values that fit in only one square of a row, column or subgrid
+		for (int unit = 0; unit < Size::UNITS; ++unit)
+		{
+			Mask used = 0, once = 0, twice = 0;
+			for (int i = 0; i < Size::SIDE; ++i)
+			{
+				int square = unitSquare<N>(unit, i);
+				if (grid.cells[square] != 0) used |= (Mask)(1u << (grid.cells[square] - 1));
+				else
+				{
+					Mask free = candidates(grid, square);
+					twice |= once & free;
+					once |= free;
+				}
+			}
+
+			// every value must have somewhere to go
+			if ((Mask)(used | once) != Size::ALL) return false;
+
+			Mask hidden = once & ~twice;
+			while (hidden)
+			{
+				unsigned int bit = hidden & (0u - hidden);
+				hidden ^= bit;
+
+				// find the square the value has to go in
+				bool found = false;
+				for (int i = 0; i < Size::SIDE && !found; ++i)
+				{
+					int square = unitSquare<N>(unit, i);
+					if (grid.cells[square] == 0 && (candidates(grid, square) & bit))
+					{
+						place(grid, square, bit);
+						found = true;
+					}
+				}
+				if (!found) return false;
+				changed = true;
+			}
+		}
+	}
+	return true;
+}
+
+// function to find the empty square with the fewest candidates
+template <int N>
+int mostConstrained(const Grid<N>& grid)
+{
+	int best = -1;
+	int fewest = BoardSize<N>::SIDE + 1;
+	for (int square = 0; square < BoardSize<N>::CELLS; ++square)
+		if (grid.cells[square] == 0)
+		{
+			int count = bitCount(candidates(grid, square));
+			if (count < fewest)
+			{
+				fewest = count;
+				best = square;
+				if (count <= 2) break;
+			}
+		}
+	return best;
+}
+
+// ITERATIVE SEARCH
+//
+// the most constrained square search and the generator keep their state in preallocated explicit stacks instead
+// of recursing, so a run can stop when its budget is spent and be resumed later without losing any work.
+
+// how much work a search may do, counted from when the budget is made (so one budget can cover several runs)
+struct SearchBudget
+{
+	long long maxNodes;                         // nodes allowed (0 for no limit)
+	long long nodeLimit;                        // stop once this thread's stats.nodes reaches this
+	chrono::steady_clock::time_point deadline; // time to stop at (time_point::max() for no limit)
+};
+
+// function to make a budget of some milliseconds and nodes from now (0 for no limit on either)
+inline SearchBudget makeBudget(double millis, long long maxNodes)
+{
+	SearchBudget budget;
+	budget.maxNodes = maxNodes;
+	budget.nodeLimit = maxNodes > 0 ? stats.nodes + maxNodes : LLONG_MAX;
+	budget.deadline = millis > 0
+		? chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, milli>(millis))
+		: chrono::steady_clock::time_point::max();
+	return budget;
+}
+
+// function to check if a budget has run out (the clock is only read when readClock is set, since it costs more
+// than a node on small boards)
+inline bool budgetSpent(const SearchBudget& budget, bool readClock)
+{
+	if (stats.nodes >= budget.nodeLimit) return true;
+	return readClock && budget.deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= budget.deadline;
+}
+
+// function to get a budget with the same deadline whose nodes are counted again from now
+inline SearchBudget restartNodes(const SearchBudget& budget)
+{
+	SearchBudget restarted = budget;
+	restarted.nodeLimit = budget.maxNodes > 0 ? stats.nodes + budget.maxNodes : LLONG_MAX;
+	return restarted;
+}
+
+// limits on the work for each puzzle in the batch modes (0 for none), set by --budget and --node-budget
+double puzzleMillis = 0;
+long long puzzleNodes = 0;
+
+// result of one run of a search
+enum SearchStatus
+{
+	SEARCH_DONE,     // finished; the search holds its result
+	SEARCH_SUSPENDED // the budget ran out; running it again continues where it stopped
+};
+
+// one level of the search stack: the grid after a placement, the square branched on and the values not yet tried there
+template <int N>
+struct SearchFrame
+{
+	Grid<N> grid;
+	int square;
+	unsigned int untried;
+};
+
+// a most constrained square search that can be suspended and resumed
+template <int N>
+struct Search
+{
+	vector<SearchFrame<N>> frames; // one per placement, plus the starting grid (allocated once)
+	int depth;                     // index of the top frame (-1 once the search is over)
+	bool branched;                 // the top frame has been propagated and its square chosen
+	bool randomOrder;              // try the candidates in a random order (to fill grids)
+	int limit;                     // stop after this many solutions
+	int numSolutions;
+	long long nodes;               // nodes expanded over every run
+	Grid<N> solution;              // the last solution found
+};
+
+// function to start a search of a grid for up to limit solutions
+template <int N>
+void startSearch(Search<N>& search, const Grid<N>& grid, int limit, bool randomOrder)
+{
+	if (search.frames.size() < (size_t)BoardSize<N>::CELLS + 1) search.frames.resize(BoardSize<N>::CELLS + 1);
+	search.frames[0].grid = grid;
+	search.depth = 0;
+	search.branched = false;
+	search.randomOrder = randomOrder;
+	search.limit = limit;
+	search.numSolutions = 0;
+	search.nodes = 0;
+}
+
+// function to run a search until it finds limit solutions, runs out of branches, or spends its budget
+template <int N>
+SearchStatus runSearch(Search<N>& search, const SearchBudget& budget)
+{
+	while (search.depth >= 0)
+	{
+		SearchFrame<N>& frame = search.frames[search.depth];
+
+		// a new frame: fill in what is forced, then record a solution or pick the square to branch on
+		if (!search.branched)
+		{
+			search.branched = true;
+			frame.untried = 0;
+			STAT(if (search.depth + 1 > stats.maxDepth) stats.maxDepth = search.depth + 1);
+
+			if (!propagate(frame.grid)) STAT(++stats.backtracks);
+			else if (frame.grid.numEmpty == 0)
+			{
+				search.solution = frame.grid;
+				if (++search.numSolutions >= search.limit) search.depth = -1;
+			}
+			else
+			{
+				frame.square = mostConstrained(frame.grid);
+				frame.untried = candidates(frame.grid, frame.square);
+			}
+			continue;
+		}
+
+		// every value has been tried here, so go back up
+		if (!frame.untried)
+		{
+			--search.depth;
+			continue;
+		}
+
+		if (budgetSpent(budget, (search.nodes & 63) == 0)) return SEARCH_SUSPENDED;
+
+		// take the next value (the lowest, or a random one) and place it on a copy of the grid one level up
+		unsigned int rest = frame.untried;
+		if (search.randomOrder)
+			for (int skip = randomInt(bitCount(rest)); skip > 0; --skip) rest &= rest - 1;
+		unsigned int bit = rest & (0u - rest);
+		frame.untried ^= bit;
+
+		SearchFrame<N>& next = search.frames[search.depth + 1];
+		next.grid = frame.grid;
+		place(next.grid, frame.square, bit);
+		++search.depth;
+		search.branched = false;
+		++search.nodes;
+		++stats.nodes;
+	}
+	return SEARCH_DONE;
+}
+
+// function to get the search object for the calling thread (so the blocking wrappers never allocate)
+template <int N>
+Search<N>& threadSearch()
+{
+	thread_local Search<N> search;
+	return search;
+}
+
+// function to solve a grid, branching on the most constrained square
+// returns false if there is no solution or the budget runs out first
+template <int N>
+bool solveMRV(Grid<N>& grid, const SearchBudget& budget = makeBudget(0, 0))
+{
+	Search<N>& search = threadSearch<N>();
+	startSearch(search, grid, 1, false);
+	runSearch(search, budget);
+	if (search.numSolutions == 0) return false;
+	grid = search.solution;
+	return true;
+}
+
+// function to count the solutions of a grid, adding them to numSolutions (stops once it reaches limit)
+// returns true if the limit was reached (false if the search ends or the budget runs out first)
+template <int N>
+bool countMRV(Grid<N>& grid, int limit, int& numSolutions, const SearchBudget& budget = makeBudget(0, 0))
+{
+	if (numSolutions >= limit) return true;
+
+	Search<N>& search = threadSearch<N>();
+	startSearch(search, grid, limit - numSolutions, false);
+	runSearch(search, budget);
+	numSolutions += search.numSolutions;
+	return numSolutions >= limit;
+}
+
+// function to fill a grid with random valid values, branching on the most constrained square
+// returns false if it can't be filled or the budget runs out first
+template <int N>
+bool randFillMRV(Grid<N>& grid, const SearchBudget& budget = makeBudget(0, 0))
+{
+	Search<N>& search = threadSearch<N>();
+	startSearch(search, grid, 1, true);
+	runSearch(search, budget);
+	if (search.numSolutions == 0) return false;
+	grid = search.solution;
+	return true;
+}
+
+// function to check if a puzzle has a solution where a square holds something other than a given value
+// returns SEARCH_SUSPENDED if the budget runs out before that is known; otherwise solvable is set
+template <int N>
+SearchStatus solvableWithout(const Grid<N>& puzzle, int square, int value, const SearchBudget& budget, bool& solvable)
+{
+	STAT(++stats.uniquenessChecks);
+
+	solvable = false;
+	Search<N>& search = threadSearch<N>();
+	unsigned int free = candidates(puzzle, square) & ~(1u << (value - 1));
+	while (free)
+	{
+		unsigned int bit = free & (0u - free);
+		free ^= bit;
+
+		Grid<N> next = puzzle;
+		place(next, square, bit);
+		++stats.nodes;
+
+		startSearch(search, next, 1, false);
+		if (runSearch(search, budget) == SEARCH_SUSPENDED) return SEARCH_SUSPENDED;
+		if (search.numSolutions > 0)
+		{
+			solvable = true;
+			break;
+		}
+	}
+	return SEARCH_DONE;
+}
+
+// one level of the generator stack: the squares that may still be removed (a slice of a shared list), and the
+// square this level removed while the levels above it work
+struct ReduceFrame
+{
+	int first;    // index of the slice in the list
+	int numCells; // squares left in the slice
+	int square;
+	int value;
+};
+
+// a generator that removes squares from a uniquely solvable grid until only numEntries remain, and that can be
+// suspended and resumed
+// each level's squares are a copy of the ones its parent had left, stored right after them in the list; a square
+// that cannot be removed at one level can't be removed above it either (fewer clues only allow more solutions),
+// so it is left out of the copy
+template <int N>
+struct Reduction
+{
+	Grid<N> puzzle;
+	vector<int> cells;          // the slices of every level (allocated once)
+	vector<ReduceFrame> frames; // one per removed square, plus the first level
+	int depth;                  // index of the top frame (-1 once it is over)
+	int numEntries;
+	bool reduced;               // it is over and puzzle has numEntries starting squares
+	Grid<N> best;               // the fewest starting squares reached so far (every state is uniquely solvable)
+};
+
+// function to start reducing a uniquely solvable grid to numEntries starting squares
+template <int N>
+void startReduction(Reduction<N>& reduction, const Grid<N>& puzzle, int numEntries)
+{
+	const int CELLS = BoardSize<N>::CELLS;
+	if (reduction.frames.size() < (size_t)CELLS + 1)
+	{
+		reduction.frames.resize(CELLS + 1);
+		reduction.cells.resize(CELLS * (CELLS + 1) / 2);
+	}
+
+	reduction.puzzle = puzzle;
+	reduction.best = puzzle;
+	reduction.numEntries = numEntries;
+	reduction.reduced = false;
+	reduction.depth = 0;
+
+	ReduceFrame& frame = reduction.frames[0];
+	frame.first = 0;
+	frame.numCells = 0;
+	for (int square = 0; square < CELLS; ++square)
+		if (puzzle.cells[square] != 0) reduction.cells[frame.numCells++] = square;
+}
+
+// function to keep removing squares until the puzzle is reduced, no order of removals works, or the budget is spent
+// (the node budget counts the nodes of the uniqueness checks)
+template <int N>
+SearchStatus runReduction(Reduction<N>& reduction, const SearchBudget& budget)
+{
+	Grid<N>& puzzle = reduction.puzzle;
+	while (reduction.depth >= 0)
+	{
+		// if we have removed enough entries, then we are done
+		if (BoardSize<N>::CELLS - puzzle.numEmpty <= reduction.numEntries)
+		{
+			reduction.reduced = true;
+			reduction.depth = -1;
+			break;
+		}
+
+		// if no squares can be safely removed at this level, then put back the square the level below removed
+		ReduceFrame& frame = reduction.frames[reduction.depth];
+		if (frame.numCells == 0)
+		{
+			if (--reduction.depth >= 0)
+			{
+				ReduceFrame& parent = reduction.frames[reduction.depth];
+				place(puzzle, parent.square, 1u << (parent.value - 1));
+			}
+			continue;
+		}
+
+		// each removal is checked as a whole, so the budget is checked before every one
+		if (budgetSpent(budget, true)) return SEARCH_SUSPENDED;
+
+		// pick a random removable square and take it off the list
+		int* cells = &reduction.cells[frame.first];
+		int index = randomInt(frame.numCells);
+		int square = cells[index];
+		cells[index] = cells[--frame.numCells];
+
+		// remove the square from the puzzle (the masks are updated in place rather than rebuilt)
+		int value = puzzle.cells[square];
+		unplace(puzzle, square);
+
+		// the puzzle stays unique exactly when no solution puts a different value in the square (if the budget runs
+		// out first, the square goes back on the list, so running again checks it from the start)
+		bool solvable = false;
+		if (solvableWithout(puzzle, square, value, budget, solvable) == SEARCH_SUSPENDED)
+		{
+			place(puzzle, square, 1u << (value - 1));
+			cells[frame.numCells++] = square;
+			return SEARCH_SUSPENDED;
+		}
+		if (solvable)
+		{
+			place(puzzle, square, 1u << (value - 1));
+			continue;
+		}
+
+		if (puzzle.numEmpty > reduction.best.numEmpty) reduction.best = puzzle;
+
+		// go up a level with the squares this one has left
+		frame.square = square;
+		frame.value = value;
+		ReduceFrame& next = reduction.frames[reduction.depth + 1];
+		next.first = frame.first + frame.numCells;
+		next.numCells = frame.numCells;
+		memcpy(&reduction.cells[next.first], cells, frame.numCells * sizeof(int));
+		++reduction.depth;
+		STAT(if (reduction.depth + 1 > stats.maxDepth) stats.maxDepth = reduction.depth + 1);
+	}
+	return SEARCH_DONE;
+}
+
+// function to reduce a uniquely solvable grid to numEntries starting squares
+// returns false if the budget runs out or no order of removals gets there; the grid is then left with the fewest
+// starting squares that were reached, which is still uniquely solvable (and still full if none could be removed)
+template <int N>
+bool generateGrid(Grid<N>& puzzle, int numEntries, const SearchBudget& budget = makeBudget(0, 0))
+{
+	thread_local Reduction<N> reduction;
+	startReduction(reduction, puzzle, numEntries);
+	runReduction(reduction, budget);
+	puzzle = reduction.reduced ? reduction.puzzle : reduction.best;
+	return reduction.reduced;
+}
+
+// function to set up the search state for a 9x9 board
+// returns false if two squares on the board conflict
+bool initState(SearchState& state, const Board& board)
+{
+	// both store the squares row by row, so the values can be used as they are
+	return initGrid(state, board.cells);
+}
+
+// function to copy the values of a search state back onto a board (starting squares are left marked)
+void copyResult(const SearchState& state, Board& board)
+{
+	memcpy(board.cells, state.cells, sizeof(board.cells));
+}
+
+// dancing links (Knuth's Algorithm X) exact cover solver
+//
+// each of the 729 matrix rows places one value in one square, and covers 4 of the 324 constraint columns:
+// the square is filled, and the value appears in its row, its column and its subgrid.
+
+const int DLX_COLUMNS = 324;
+const int DLX_ROWS = 729;
+const int DLX_NODES = 1 + DLX_COLUMNS + DLX_ROWS * 4; // root, column headers, then 4 nodes per row
+
+// a node in the exact cover matrix (links are indices into the node arena)
+struct DLXNode
+{
+	int left, right, up, down;
+	int column;
+	int row;
+};
+
+// exact cover matrix and search state, with every node stored in one contiguous arena
+struct DLX
+{
+	DLXNode nodes[DLX_NODES];
+	int size[DLX_COLUMNS + 1];
+
+	// rows chosen by the search
+	int selected[81];
+	int depth;
+
+	// board being solved, the first solution found and the number of solutions found so far
+	Board board;
+	Board solution;
+	long long numSolutions;
+	long long limit; // stop after this many solutions (0 means find them all)
+
+	// optional function called with every solution (return false to stop searching)
+	bool (*callback)(const Board& solution, void* data);
+	void* data;
+};
+
+// function to build the full exact cover matrix with no squares filled in
+DLX* buildDLX()
+{
+	DLX* dlx = new DLX;
+	DLXNode* nodes = dlx->nodes;
+
+	// the root and the column headers form a circular list
+	for (int c = 0; c <= DLX_COLUMNS; ++c)
+	{
+		nodes[c].left = c == 0 ? DLX_COLUMNS : c - 1;
+		nodes[c].right = c == DLX_COLUMNS ? 0 : c + 1;
+		nodes[c].up = nodes[c].down = c;
+		nodes[c].column = c;
+		nodes[c].row = -1;
+		dlx->size[c] = 0;
+	}
+
+	for (int row = 0; row < DLX_ROWS; ++row)
+	{
+		int square = row / 9;
+		int y = square / 9;
+		int x = square % 9;
+		int value = row % 9;
+
+		// constraint columns (header indices start at 1)
+		int columns[4] =
+		{
+			1 + square,
+			1 + 81 + y * 9 + value,
+			1 + 162 + x * 9 + value,
+			1 + 243 + boxIndex(x, y) * 9 + value
+		};
+
+		int first = 1 + DLX_COLUMNS + row * 4;
+		for (int k = 0; k < 4; ++k)
+		{
+			int n = first + k;
+			int c = columns[k];
+
+			// link the row's nodes into a circular list
+			nodes[n].left = first + (k + 3) % 4;
+			nodes[n].right = first + (k + 1) % 4;
+
+			// append the node to the bottom of its column
+			nodes[n].up = nodes[c].up;
+			nodes[n].down = c;
+			nodes[nodes[c].up].down = n;
+			nodes[c].up = n;
+
+			nodes[n].column = c;
+			nodes[n].row = row;
+			++dlx->size[c];
+		}
+	}
+
+	return dlx;
+}
+
+// function to remove a column and every row that intersects it from the matrix
+inline void cover(DLX* dlx, int c)
+{
+	DLXNode* nodes = dlx->nodes;
+	nodes[nodes[c].right].left = nodes[c].left;
+	nodes[nodes[c].left].right = nodes[c].right;
+	for (int i = nodes[c].down; i != c; i = nodes[i].down)
+		for (int j = nodes[i].right; j != i; j = nodes[j].right)
+		{
+			nodes[nodes[j].down].up = nodes[j].up;
+			nodes[nodes[j].up].down = nodes[j].down;
+			--dlx->size[nodes[j].column];
+		}
+}
+
+// function to put a covered column back into the matrix (in the reverse order of cover)
+inline void uncover(DLX* dlx, int c)
+{
+	DLXNode* nodes = dlx->nodes;
+	for (int i = nodes[c].up; i != c; i = nodes[i].up)
+		for (int j = nodes[i].left; j != i; j = nodes[j].left)
+		{
+			++dlx->size[nodes[j].column];
+			nodes[nodes[j].down].up = j;
+			nodes[nodes[j].up].down = j;
+		}
+	nodes[nodes[c].right].left = c;
+	nodes[nodes[c].left].right = c;
+}
+
+// function to set up the matrix for a board (returns false if the starting squares conflict)
+bool initDLX(DLX* dlx, const Board& board)
+{
+	// copy the empty matrix instead of rebuilding it every time
+	static const DLX* empty = buildDLX();
+	*dlx = *empty;
+
+	dlx->depth = 0;
+	dlx->numSolutions = 0;
+	dlx->limit = 0;
+	dlx->callback = NULL;
+	dlx->data = NULL;
+
+	dlx->board = board;
+	for (int square = 0; square < 81; ++square)
+	{
+		if (board.cells[square] == 0) continue;
+
+		// select the row for the filled square by covering all of its columns
+		int first = 1 + DLX_COLUMNS + (square * 9 + board.cells[square] - 1) * 4;
+		for (int k = 0; k < 4; ++k)
+		{
+			int c = dlx->nodes[first + k].column;
+
+			// if a column has already been covered, then two squares conflict
+			if (dlx->nodes[dlx->nodes[c].right].left != c) return false;
+			cover(dlx, c);
+		}
+	}
+	return true;
+}
+
+// function to run Algorithm X; returns true when the search should stop
+bool searchDLX(DLX* dlx)
+{
+	STAT(DepthGuard depth);
+
+	DLXNode* nodes = dlx->nodes;
+
+	// if every column is covered, then we have a solution
+	if (nodes[0].right == 0)
+	{
+		Board solution = dlx->board;
+		for (int i = 0; i < dlx->depth; ++i)
+			solution.cells[dlx->selected[i] / 9] = (uint8_t)(dlx->selected[i] % 9 + 1);
+
+		++dlx->numSolutions;
+		if (dlx->numSolutions == 1) dlx->solution = solution;
+
+		if (dlx->callback && !dlx->callback(solution, dlx->data)) return true;
+		return dlx->limit > 0 && dlx->numSolutions >= dlx->limit;
+	}
+
+	// choose the column with the fewest rows
+	int c = nodes[0].right;
+	for (int j = nodes[c].right; j != 0; j = nodes[j].right)
+		if (dlx->size[j] < dlx->size[c]) c = j;
+	if (dlx->size[c] == 0)
+	{
+		STAT(++stats.backtracks);
+		return false;
+	}
+
+	cover(dlx, c);
+	bool stop = false;
+	for (int r = nodes[c].down; r != c && !stop; r = nodes[r].down)
+	{
+		dlx->selected[dlx->depth++] = nodes[r].row;
+		++stats.nodes;
+
+		for (int j = nodes[r].right; j != r; j = nodes[j].right)
+			cover(dlx, nodes[j].column);
+
+		stop = searchDLX(dlx);
+
+		for (int j = nodes[r].left; j != r; j = nodes[j].left)
+			uncover(dlx, nodes[j].column);
+		--dlx->depth;
+	}
+	uncover(dlx, c);
+	return stop;
+}
+
+// function to solve a board with dancing links
+bool dlxSolve(Board& board)
+{
+	DLX* dlx = new DLX;
+	bool solved = false;
+	if (initDLX(dlx, board))
+	{
+		dlx->limit = 1;
+		searchDLX(dlx);
+		solved = dlx->numSolutions > 0;
+		if (solved) board = dlx->solution;
+	}
+	delete dlx;
+	return solved;
+}
+
+// function to count the solutions of a board with dancing links (stops at limit, 0 counts them all)
+long long dlxCount(const Board& board, long long limit)
+{
+	DLX* dlx = new DLX;
+	long long numSolutions = 0;
+	if (initDLX(dlx, board))
+	{
+		dlx->limit = limit;
+		searchDLX(dlx);
+		numSolutions = dlx->numSolutions;
+	}
+	delete dlx;
+	return numSolutions;
+}
+
+// function to call a function with every solution of a board (the callback returns false to stop early)
+long long dlxEnumerate(const Board& board, bool (*callback)(const Board& solution, void* data), void* data)
+{
+	DLX* dlx = new DLX;
+	long long numSolutions = 0;
+	if (initDLX(dlx, board))
+	{
+		dlx->callback = callback;
+		dlx->data = data;
+		searchDLX(dlx);
+		numSolutions = dlx->numSolutions;
+	}
+	delete dlx;
+	return numSolutions;
+}
+
+// a queue of tasks owned by one worker thread
+struct WorkQueue
+{
+	mutex lock;
+	deque<function<void()>> tasks;
+};
+
+// work-stealing thread pool: each worker runs tasks from the back of its own queue,
+// and steals from the front of the other queues when its own runs dry
+struct WorkPool
+{
+	vector<unique_ptr<WorkQueue>> queues;
+	atomic<long long> pending; // tasks that are queued or running
+	int nextQueue;             // queue for the next task submitted from outside the pool
+};
+
+// index of the pool worker running on this thread (-1 for threads outside the pool)
+thread_local int workerIndex = -1;
+
+// function to set up a pool with one queue per worker
+void initPool(WorkPool& pool, int numThreads)
+{
+	pool.queues.clear();
+	for (int i = 0; i < numThreads; ++i) pool.queues.push_back(unique_ptr<WorkQueue>(new WorkQueue));
+	pool.pending = 0;
+	pool.nextQueue = 0;
+}
+
+// function to add a task to the pool (tasks submitted by a worker go onto its own queue)
+void submit(WorkPool& pool, function<void()> task)
+{
+	int index = workerIndex;
+	if (index < 0)
+	{
+		index = pool.nextQueue;
+		pool.nextQueue = (pool.nextQueue + 1) % (int)pool.queues.size();
+	}
+
+	++pool.pending;
+	lock_guard<mutex> guard(pool.queues[index]->lock);
+	pool.queues[index]->tasks.push_back(task);
+}
+
+// function to take a task for a worker, stealing one if its own queue is empty
+bool takeTask(WorkPool& pool, int index, function<void()>& task)
+{
+	int numQueues = (int)pool.queues.size();
+	for (int i = 0; i < numQueues; ++i)
+	{
+		WorkQueue& queue = *pool.queues[(index + i) % numQueues];
+		lock_guard<mutex> guard(queue.lock);
+		if (queue.tasks.empty()) continue;
+
+		if (i == 0)
+		{
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+		return true;
+	}
+	return false;
+}
+
+// function to run every task in the pool (including tasks added while running) and wait for them to finish
+// setup, if given, is called on each worker thread before it starts taking tasks
+void runPool(WorkPool& pool, function<void(int)> setup)
+{
+	vector<thread> threads;
+	for (int i = 0; i < (int)pool.queues.size(); ++i)
+		threads.push_back(thread([&pool, &setup, i]()
+		{
+			workerIndex = i;
+			if (setup) setup(i);
+
+			function<void()> task;
+			while (pool.pending > 0)
+			{
+				if (takeTask(pool, i, task))
+				{
+					task();
+					--pool.pending;
+				}
+				else this_thread::yield();
+			}
+			workerIndex = -1;
+
+			// hand this worker's statistics to the rest of the program
+			lock_guard<mutex> guard(workerStatsLock);
+			addStats(workerStats, stats);
+		}));
+
+	for (int i = 0; i < (int)threads.size(); ++i) threads[i].join();
+}
+
+// shared state for a search that is split across several threads
+struct ParallelSearch
+{
+	WorkPool pool;
+	int splitDepth;              // branches above this depth become separate tasks
+	int limit;                   // stop once this many solutions have been found
+	atomic<int> numSolutions;
+	atomic<bool> cancelled;      // set once the search can stop; every task checks it as it goes
+	mutex lock;
+	SearchState solution;        // first solution found
+};
+
+// function to search one subtree; shallow branches are handed to the pool, deeper ones are searched in place
+void parallelBranch(ParallelSearch& search, SearchState& state, int depth)
+{
+	STAT(DepthGuard guard);
+
+	if (search.cancelled) return;
+	if (!propagate(state))
+	{
+		STAT(++stats.backtracks);
+		return;
+	}
+
+	// record the solution, and cancel the other subtrees once we have enough
+	if (state.numEmpty == 0)
+	{
+		int found = ++search.numSolutions;
+		if (found == 1)
+		{
+			lock_guard<mutex> guard(search.lock);
+			search.solution = state;
+		}
+		if (found >= search.limit) search.cancelled = true;
+		return;
+	}
+
+	int square = mostConstrained(state);
+
+	unsigned int free = candidates(state, square);
+	while (free && !search.cancelled)
+	{
+		unsigned int bit = free & (0u - free);
+		free ^= bit;
+
+		SearchState next = state;
+		place(next, square, bit);
+		++stats.nodes;
+
+		if (depth < search.splitDepth)
+		{
+			submit(search.pool, [&search, next, depth]()
+			{
+				SearchState branch = next;
+				parallelBranch(search, branch, depth + 1);
+			});
+		}
+		else parallelBranch(search, next, depth + 1);
+	}
+}
+
+// function to search a board on several threads; returns the number of solutions found (at most limit)
+// the first solution found is copied onto the board
+int parallelSearch(Board& board, int limit, int numThreads)
+{
+	SearchState root;
+	if (!initState(root, board)) return 0;
+
+	ParallelSearch search;
+	initPool(search.pool, numThreads);
+	search.limit = limit;
+	search.numSolutions = 0;
+	search.cancelled = false;
+
+	// split deep enough to give every thread several subtrees to steal
+	search.splitDepth = 1;
+	while ((1 << search.splitDepth) < numThreads * 8) ++search.splitDepth;
+
+	submit(search.pool, [&search, root]()
+	{
+		SearchState branch = root;
+		parallelBranch(search, branch, 0);
+	});
+	runPool(search.pool, NULL);
+
+	if (search.numSolutions > 0) copyResult(search.solution, board);
+
+	// workers that finish at the same moment can overshoot the limit
+	return search.numSolutions < limit ? search.numSolutions.load() : limit;
+}
+
+// function to solve a sudoku board
+bool solve(Board& board)
+{
+	STAT(PhaseTimer timer(PHASE_SOLVE));
+
+	if (strategy == NAIVE) return solveNaive(board);
+	if (strategy == DANCING_LINKS) return dlxSolve(board);
+
+	if (strategy == BITMASK)
+	{
+		// build the row, column and subgrid masks once; they are updated incrementally while searching
+		Masks masks;
+		buildMasks(board, masks);
+
+		int cells[81];
+		int numCells = emptyCells(board, cells);
+		return solveCells(board, masks, cells, 0, numCells);
+	}
+
+	if (solverThreads > 1) return parallelSearch(board, 1, solverThreads) > 0;
+
+	SearchState state;
+	if (!initState(state, board)) return false;
+	if (!solveMRV(state)) return false;
+	copyResult(state, board);
+	return true;
+}
+
+// function to solve a board within the limits on each puzzle of the batch modes (with the mrv search when there are any)
+// returns false if the board has no solution or the limits run out first
+bool solveLimited(Board& board)
+{
+	if (puzzleMillis <= 0 && puzzleNodes <= 0) return solve(board);
+
+	SearchState state;
+	if (!initState(state, board)) return false;
+	if (!solveMRV(state, makeBudget(puzzleMillis, puzzleNodes))) return false;
+	copyResult(state, board);
+	return true;
+}
+
+// function to fill a board with random valid values
+bool randFill(Board& board)
+{
+	STAT(PhaseTimer timer(PHASE_FILL));
+	STAT(DepthGuard depth);
+
+	if (strategy == NAIVE)
+	{
+		// find an empty square
+		for (int x = 0; x < 9; ++x)
+			for (int y = 0; y < 9; ++y)
+				if (board.cells[squareIndex(x, y)] == 0)
+				{
+					int values[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+					int numValues = 9;
+
+					// try values in a random order
+					while (numValues)
+					{
+						// randomly choose a value
+						int index = randomInt(numValues);
+						int value = values[index];
+
+						// remove the chosen value from the array
+						--numValues;
+						for (int i = index; i < numValues; ++i)
+							values[i] = values[i + 1];
+
+						// if the value is legal, then try it and recurse
+						if (isLegal(board, x, y, value))
+						{
+							board.cells[squareIndex(x, y)] = (uint8_t)value;
+							++stats.nodes;
+							if (randFill(board)) return true;
+						}
+					}
+
+					// if no values were found, then backtrack
+					board.cells[squareIndex(x, y)] = 0;
+					STAT(++stats.backtracks);
+					return false;
+				}
+
+		// if no squares are empty, then we are done
+		return true;
+	}
+
+	if (strategy == BITMASK)
+	{
+		Masks masks;
+		buildMasks(board, masks);
+
+		int cells[81];
+		int numCells = emptyCells(board, cells);
+		return randFillCells(board, masks, cells, 0, numCells);
+	}
+
+	// dancing links has no random fill, so it shares the MRV one
+	SearchState state;
+	if (!initState(state, board)) return false;
+	if (!randFillMRV(state)) return false;
+	copyResult(state, board);
+	return true;
+}
+
+// function to detect if a board has multiple solutions
+bool multiSolve(Board& board, int& numSolutions)
+{
+	STAT(PhaseTimer timer(PHASE_COUNT));
+	STAT(DepthGuard depth);
+
+	if (strategy == NAIVE)
+	{
+		// find an empty square
+		for (int x = 0; x < 9; ++x)
+			for (int y = 0; y < 9; ++y)
+				if (board.cells[squareIndex(x, y)] == 0)
+				{
+					// loop through all legal values for the square
+					for (int i = 1; i <= 9; ++i)
+						if (isLegal(board, x, y, i))
+						{
+							board.cells[squareIndex(x, y)] = (uint8_t)i;
+							++stats.nodes;
+
+							// recursive call
+							if (multiSolve(board, numSolutions)) return true;
+						}
+
+					// backtrack
+					board.cells[squareIndex(x, y)] = 0;
+					STAT(++stats.backtracks);
+					return false;
+				}
+
+		// if the board is full, increment solution counter and return
+		++numSolutions;
+		return numSolutions >= 2;
+	}
+
+	if (strategy == BITMASK)
+	{
+		Masks masks;
+		buildMasks(board, masks);
+
+		int cells[81];
+		int numCells = emptyCells(board, cells);
+		return multiSolveCells(board, masks, cells, 0, numCells, numSolutions);
+	}
+
+	if (strategy == DANCING_LINKS)
+	{
+		if (numSolutions < 2) numSolutions += (int)dlxCount(board, 2 - numSolutions);
+		return numSolutions >= 2;
+	}
+
+	if (solverThreads > 1)
+	{
+		// each call counts its own solutions, so search the remainder on a copy of the board
+		Board temp = board;
+		if (numSolutions < 2) numSolutions += parallelSearch(temp, 2 - numSolutions, solverThreads);
+		return numSolutions >= 2;
+	}
+
+	SearchState state;
+	if (!initState(state, board)) return false;
+	return countMRV(state, 2, numSolutions);
+}
+
+// function to count the solutions of a board, stopping as soon as limit solutions have been found
+int countSolutions(const Board& board, int limit)
+{
+	STAT(PhaseTimer timer(PHASE_COUNT));
+
+	int numSolutions = 0;
+	if (limit <= 0) return 0;
+
+	SearchState state;
+	if (!initState(state, board)) return 0;
+	countMRV(state, limit, numSolutions);
+	return numSolutions;
+}
+
+// SOLUTION CACHE
+//
+// solutions of recently solved puzzles, keyed by a Zobrist hash of their starting squares, so asking for
+// hints or solving the same puzzle again doesn't search again. the least recently used entry is dropped
+// when the cache is full, and the cache is saved to solutions.txt in the working directory so it survives restarts.
+
+// random keys for every value in every square, for hashing the starting squares of a board
+struct ZobristTable
+{
+	uint64_t keys[81][10];
+};
+
+// function to fill the hash keys from a fixed seed (splitmix64), so a puzzle gets the same hash in every run
+ZobristTable makeZobristTable()
+{
+	ZobristTable table;
+	uint64_t state = 0;
+	for (int square = 0; square < 81; ++square)
+		for (int value = 0; value < 10; ++value)
+		{
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			table.keys[square][value] = z ^ (z >> 31);
+		}
+	return table;
+}
+
+const ZobristTable ZOBRIST = makeZobristTable();
+
+// function to hash the starting squares of a board (the player's entries don't change the hash)
+uint64_t givensHash(const Board& board)
+{
+	uint64_t hash = 0;
+	for (int square = 0; square < 81; ++square)
+		if (isGiven(board, square)) hash ^= ZOBRIST.keys[square][board.cells[square]];
+	return hash;
+}
+
+// function to check if two boards have the same starting squares
+bool sameGivens(const Board& a, const Board& b)
+{
+	if (a.givens[0] != b.givens[0] || a.givens[1] != b.givens[1]) return false;
+	for (int square = 0; square < 81; ++square)
+		if (isGiven(a, square) && a.cells[square] != b.cells[square]) return false;
+	return true;
+}
+
+// one cached puzzle
+struct CachedSolution
+{
+	uint64_t key;   // givensHash() of the puzzle
+	Board solution; // the solved board (just the starting squares if there is no solution)
+	bool solved;
+};
+
+const size_t SOLUTION_CACHE_SIZE = 1024;
+const char* SOLUTION_CACHE_FILE = "solutions.txt";
+
+list<CachedSolution> solutionCache;                                   // most recently used first
+unordered_map<uint64_t, list<CachedSolution>::iterator> solutionIndex; // key -> entry in solutionCache
+bool persistSolutions = true;                                          // save the cache when the game exits
+long long cacheHits = 0;
+long long cacheMisses = 0;
+
+// function to add a solution to the front of the cache (replacing any entry with the same key)
+void cacheSolution(const Board& solution, bool solved)
+{
+	uint64_t key = givensHash(solution);
+	auto found = solutionIndex.find(key);
+	if (found != solutionIndex.end())
+	{
+		solutionCache.erase(found->second);
+		solutionIndex.erase(found);
+	}
+
+	CachedSolution entry = { key, solution, solved };
+	solutionCache.push_front(entry);
+	solutionIndex[key] = solutionCache.begin();
+
+	// drop the least recently used entry
+	if (solutionCache.size() > SOLUTION_CACHE_SIZE)
+	{
+		solutionIndex.erase(solutionCache.back().key);
+		solutionCache.pop_back();
+	}
+}
+
+// function to empty the cache
+void clearSolutions()
+{
+	solutionCache.clear();
+	solutionIndex.clear();
+	cacheHits = 0;
+	cacheMisses = 0;
+}
+
+// function to look up the solution of the puzzle on a board (ignoring the player's entries)
+// returns false if it isn't cached; otherwise solved is set (solution is just the starting squares if there is none)
+bool findCached(const Board& board, Board& solution, bool& solved)
+{
+	// a hash collision finds a different puzzle, which counts as a miss
+	auto found = solutionIndex.find(givensHash(board));
+	if (found == solutionIndex.end() || !sameGivens(found->second->solution, board))
+	{
+		++cacheMisses;
+		return false;
+	}
+
+	++cacheHits;
+	solutionCache.splice(solutionCache.begin(), solutionCache, found->second);
+	solution = found->second->solution;
+	solved = found->second->solved;
+	return true;
+}
+
+// function to solve the puzzle on a board from its starting squares and cache the result
+// returns false if the puzzle has no solution (solution is then just the starting squares)
+bool solveAndCache(const Board& board, Board& solution)
+{
+	Board puzzle = board;
+	for (int square = 0; square < 81; ++square)
+		if (!isGiven(puzzle, square)) puzzle.cells[square] = 0;
+	solution = puzzle;
+	bool solved = solve(solution);
+	if (!solved) solution = puzzle;
+
+	cacheSolution(solution, solved);
+	return solved;
+}
+
+// function to get the solution of the puzzle on a board (ignoring the player's entries), solving it only if it isn't cached
+// returns false if the puzzle has no solution (solution is then just the starting squares)
+bool cachedSolve(const Board& board, Board& solution)
+{
+	bool solved = false;
+	if (findCached(board, solution, solved)) return solved;
+	return solveAndCache(board, solution);
+}
+
+// a solve in the game that used up its time slice, kept so that the next "solve" continues it
+const double SOLVE_SLICE_MS = 2000;
+Search<3> pausedSearch;
+Board pausedPuzzle;      // starting squares of the puzzle being searched
+bool searchPaused = false;
+
+// function to run the mrv search on the puzzle on a board for at most one time slice (continuing the paused search
+// if it is for the same puzzle), caching the result once the search is over
+// returns SEARCH_SUSPENDED if the slice ran out; otherwise solved is set as by solveAndCache()
+SearchStatus solveSlice(const Board& board, Board& solution, bool& solved)
+{
+	STAT(PhaseTimer timer(PHASE_SOLVE));
+
+	Board puzzle = board;
+	for (int square = 0; square < 81; ++square)
+		if (!isGiven(puzzle, square)) puzzle.cells[square] = 0;
+
+	if (!searchPaused || !sameGivens(pausedPuzzle, puzzle))
+	{
+		SearchState state;
+		pausedPuzzle = puzzle;
+		searchPaused = false;
+		if (!initState(state, puzzle))
+		{
+			solved = false;
+			solution = puzzle;
+			cacheSolution(solution, solved);
+			return SEARCH_DONE;
+		}
+		startSearch(pausedSearch, state, 1, false);
+	}
+
+	searchPaused = runSearch(pausedSearch, makeBudget(SOLVE_SLICE_MS, 0)) == SEARCH_SUSPENDED;
+	if (searchPaused) return SEARCH_SUSPENDED;
+
+	solved = pausedSearch.numSolutions > 0;
+	solution = puzzle;
+	if (solved) copyResult(pausedSearch.solution, solution);
+	cacheSolution(solution, solved);
+	return SEARCH_DONE;
+}
+
+// function to save the cache as text, least recently used first
+// each line is the puzzle, a space, then its solution ('-' if it has none)
+bool saveSolutions(string filename)
+{
+	ofstream fout(filename);
+	if (fout.fail()) return false;
+
+	for (auto entry = solutionCache.rbegin(); entry != solutionCache.rend(); ++entry)
+	{
+		Board puzzle = entry->solution;
+		for (int square = 0; square < 81; ++square)
+			if (!isGiven(puzzle, square)) puzzle.cells[square] = 0;
+		fout << toLine(puzzle) << ' ' << (entry->solved ? toLine(entry->solution) : "-") << '\n';
+	}
+
+	bool written = !fout.fail();
+	fout.close();
+	return written;
+}
+
+// function to load a saved cache (lines that are malformed or don't hold a correct solution of their puzzle are skipped)
+// returns false if the file can't be opened
+bool loadSolutions(string filename)
+{
+	ifstream fin(filename);
+	if (fin.fail()) return false;
+
+	string line;
+	while (getline(fin, line))
+	{
+		Board puzzle;
+		if (line.length() < 83 || line[81] != ' ' || !fromLine(line.c_str(), 81, puzzle)) continue;
+		if (line[82] == '-')
+		{
+			cacheSolution(puzzle, false);
+			continue;
+		}
+
+		// the solution has to be full, correct, and agree with the puzzle
+		Board solution;
+		if (!fromLine(line.c_str() + 82, (int)line.length() - 82, solution)) continue;
+		solution.givens[0] = puzzle.givens[0];
+		solution.givens[1] = puzzle.givens[1];
+		if (!sameGivens(solution, puzzle)) continue;
+
+		Masks masks;
+		buildMasks(solution, masks);
+		unsigned int full = ALL_VALUES;
+		for (int i = 0; i < 9; ++i)
+			full &= masks.rows[i] & masks.cols[i] & masks.boxes[i];
+		if (full == ALL_VALUES) cacheSolution(solution, true);
+	}
+
+	fin.close();
+	return true;
+}
+
+// CANONICAL FORM
+//
+// puzzles that differ only by a sudoku symmetry (relabeling the values, permuting the rows within a band or the
+// columns within a stack, permuting the bands or the stacks, or transposing) are the same puzzle. the canonical
+// form is the smallest line (empty squares as 0) over all of those symmetries. it is built one row at a time,
+// keeping only the partial symmetries whose rows so far are the smallest, so most symmetries are never finished.
+
+// orders of three things
+const int ORDERS_OF_3[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+
+// an order of the columns that keeps the stacks together
+struct ColumnOrder
+{
+	uint8_t cols[9]; // source column at each column of the result
+};
+
+// function to list all 1296 column orders (stack order, then the order within each stack)
+vector<ColumnOrder> makeColumnOrders()
+{
+	vector<ColumnOrder> orders;
+	for (int stacks = 0; stacks < 6; ++stacks)
+		for (int a = 0; a < 6; ++a)
+			for (int b = 0; b < 6; ++b)
+				for (int c = 0; c < 6; ++c)
+				{
+					int within[3] = { a, b, c };
+					ColumnOrder order;
+					for (int i = 0; i < 3; ++i)
+						for (int j = 0; j < 3; ++j)
+							order.cols[i * 3 + j] = (uint8_t)(ORDERS_OF_3[stacks][i] * 3 + ORDERS_OF_3[within[i]][j]);
+					orders.push_back(order);
+				}
+	return orders;
+}
+
+const vector<ColumnOrder> COLUMN_ORDERS = makeColumnOrders();
+
+// most partial symmetries canonicalForm() keeps at a time (puzzles with few starting squares, or conflicting ones,
+// can tie on almost every order of the rows and columns)
+const size_t MAX_TIED_SYMMETRIES = 1 << 16;
+
+// a symmetry whose first rows have been chosen
+struct PartialSymmetry
+{
+	const uint8_t* grid; // the puzzle, or its transpose
+	const ColumnOrder* order;
+	uint8_t rows[9];     // source row at each row of the result chosen so far
+	uint8_t labels[10];  // value in the result of each source value (0 until it first appears)
+	uint8_t numLabels;
+	uint16_t usedRows;   // bit r is set once source row r has been used
+};
+
+// function to find the canonical form of the puzzle on a board (only its starting squares count)
+// returns false if more than MAX_TIED_SYMMETRIES partial symmetries tie, which leaves canonical unusable
+bool canonicalForm(const Board& board, Board& canonical)
+{
+	// the puzzle and its transpose
+	uint8_t grids[2][81];
+	for (int square = 0; square < 81; ++square)
+	{
+		uint8_t value = isGiven(board, square) ? board.cells[square] : 0;
+		grids[0][square] = value;
+		grids[1][(square % 9) * 9 + square / 9] = value;
+	}
+
+	clearBoard(canonical);
+	vector<PartialSymmetry> current, next;
+	int level = 0;
+	bool found = false;
+	bool overflow = false; // a tie was dropped because there were too many
+
+	// function to add a row to a partial symmetry, keeping it only if its row is as small as the best one at this level
+	auto extend = [&](const PartialSymmetry& symmetry, int row)
+	{
+		uint8_t* best = canonical.cells + level * 9;
+
+		// relabel the row, giving up as soon as it is larger than the best row
+		PartialSymmetry extended = symmetry;
+		const uint8_t* source = symmetry.grid + row * 9;
+		uint8_t line[9];
+		int compare = found ? 0 : -1;
+		for (int i = 0; i < 9 && compare <= 0; ++i)
+		{
+			uint8_t value = source[symmetry.order->cols[i]];
+			if (value && !extended.labels[value]) extended.labels[value] = ++extended.numLabels;
+			line[i] = extended.labels[value];
+			if (compare == 0 && line[i] != best[i]) compare = line[i] < best[i] ? -1 : 1;
+		}
+		if (compare > 0) return;
+
+		if (compare < 0)
+		{
+			memcpy(best, line, 9);
+			found = true;
+			overflow = false;
+			next.clear();
+		}
+		else if (next.size() >= MAX_TIED_SYMMETRIES)
+		{
+			overflow = true;
+			return;
+		}
+		extended.rows[level] = (uint8_t)row;
+		extended.usedRows |= 1 << row;
+		next.push_back(extended);
+	};
+
+	// the first row: a row is smaller when its empty squares come first, and that only depends on the order of the
+	// columns, so the stacks go in order of how early their empty squares can be, and only the column orders that
+	// reach the smallest pattern of filled squares are tried
+	unsigned int bestPattern = ~0u;
+	for (int t = 0; t < 2; ++t)
+		for (int row = 0; row < 9; ++row)
+		{
+			// filled squares of each stack in each order, as 3 bits (first column highest)
+			const uint8_t* source = grids[t] + row * 9;
+			unsigned int patterns[3][6], smallest[3];
+			for (int stack = 0; stack < 3; ++stack)
+			{
+				smallest[stack] = 7;
+				for (int w = 0; w < 6; ++w)
+				{
+					unsigned int pattern = 0;
+					for (int j = 0; j < 3; ++j)
+						pattern = pattern << 1 | (source[stack * 3 + ORDERS_OF_3[w][j]] != 0);
+					patterns[stack][w] = pattern;
+					smallest[stack] = min(smallest[stack], pattern);
+				}
+			}
+
+			unsigned int sorted[3] = { smallest[0], smallest[1], smallest[2] };
+			sort(sorted, sorted + 3);
+			unsigned int pattern = sorted[0] << 6 | sorted[1] << 3 | sorted[2];
+			if (pattern > bestPattern) continue;
+			bestPattern = pattern;
+
+			for (int stacks = 0; stacks < 6; ++stacks)
+			{
+				const int* order = ORDERS_OF_3[stacks];
+				if (smallest[order[0]] != sorted[0] || smallest[order[1]] != sorted[1] || smallest[order[2]] != sorted[2]) continue;
+				for (int a = 0; a < 6; ++a)
+				{
+					if (patterns[order[0]][a] != sorted[0]) continue;
+					for (int b = 0; b < 6; ++b)
+					{
+						if (patterns[order[1]][b] != sorted[1]) continue;
+						for (int c = 0; c < 6; ++c)
+						{
+							if (patterns[order[2]][c] != sorted[2]) continue;
+
+							PartialSymmetry symmetry;
+							symmetry.grid = grids[t];
+							symmetry.order = &COLUMN_ORDERS[((stacks * 6 + a) * 6 + b) * 6 + c];
+							memset(symmetry.labels, 0, sizeof(symmetry.labels));
+							symmetry.numLabels = 0;
+							symmetry.usedRows = 0;
+							extend(symmetry, row);
+						}
+					}
+				}
+			}
+		}
+	if (overflow) return false;
+	swap(current, next);
+
+	// the other rows: the first row of a band can come from any unused band, the others from the band of the row above
+	for (level = 1; level < 9; ++level)
+	{
+		found = false;
+		next.clear();
+		overflow = false;
+		for (const PartialSymmetry& symmetry : current)
+		{
+			if (level % 3 == 0)
+			{
+				for (int row = 0; row < 9; ++row)
+					if (!((symmetry.usedRows >> (row / 3 * 3)) & 7)) extend(symmetry, row);
+			}
+			else
+			{
+				int band = symmetry.rows[level - 1] / 3 * 3;
+				for (int row = band; row < band + 3; ++row)
+					if (!((symmetry.usedRows >> row) & 1)) extend(symmetry, row);
+			}
+		}
+		if (overflow) return false;
+		swap(current, next);
+	}
+
+	for (int square = 0; square < 81; ++square)
+		setGiven(canonical, square, canonical.cells[square] != 0);
+	return true;
+}
+
+// a set of puzzles (packed) with their hashes: open addressing with linear probing on the hashes, in a power of two
+// table of puzzle numbers that is kept at most half full. a puzzle is only found if the packed board matches as well
+// as the hash, so two different puzzles whose hashes collide are both kept
+struct PuzzleSet
+{
+	vector<uint32_t> slots;      // 1 + index of a puzzle (0 marks an empty slot)
+	vector<uint64_t> hashes;     // hash of each puzzle
+	vector<PackedBoard> puzzles;
+};
+
+// function to find the slot of a puzzle in a set, or the empty slot where it would go
+size_t findSlot(const PuzzleSet& set, uint64_t hash, const PackedBoard& packed)
+{
+	size_t mask = set.slots.size() - 1;
+	for (size_t i = hash & mask; ; i = (i + 1) & mask)
+	{
+		uint32_t slot = set.slots[i];
+		if (slot == 0) return i;
+		if (set.hashes[slot - 1] == hash && memcmp(set.puzzles[slot - 1].bytes, packed.bytes, PACKED_SIZE) == 0) return i;
+	}
+}
+
+// function to add a puzzle and its hash to a set, doubling the table when it gets half full
+// returns false if it was already there
+bool insertPuzzle(PuzzleSet& set, const Board& puzzle, uint64_t hash)
+{
+	if ((set.puzzles.size() + 1) * 2 > set.slots.size())
+	{
+		set.slots.assign(set.slots.empty() ? 1024 : set.slots.size() * 2, 0);
+		size_t mask = set.slots.size() - 1;
+		for (size_t index = 0; index < set.puzzles.size(); ++index)
+		{
+			size_t i = set.hashes[index] & mask;
+			while (set.slots[i]) i = (i + 1) & mask;
+			set.slots[i] = (uint32_t)(index + 1);
+		}
+	}
+
+	PackedBoard packed;
+	packBoard(puzzle, packed);
+	size_t i = findSlot(set, hash, packed);
+	if (set.slots[i]) return false;
+	set.hashes.push_back(hash);
+	set.puzzles.push_back(packed);
+	set.slots[i] = (uint32_t)set.puzzles.size();
+	return true;
+}
+
+// DIFFICULTY RATING
+//
+// a puzzle is rated by solving it the way a person would: with an ordered list of logical techniques, always using
+// the simplest one that makes progress. the rating is the hardest technique that was needed and the number of
+// steps; puzzles that the techniques can't finish need guessing and are rated SEARCH.
+
+// solving techniques, simplest first
+enum Technique
+{
+	NAKED_SINGLE,  // a square with one candidate
+	HIDDEN_SINGLE, // a value with one place in a unit
+	NAKED_PAIR,    // two squares of a unit with the same two candidates
+	POINTING,      // a value whose places in a subgrid are all in one row or column
+	BOX_LINE,      // a value whose places in a row or column are all in one subgrid
+	X_WING,        // a value with two places in each of two rows (or columns), in the same two columns (or rows)
+	SEARCH,        // none of the above is enough
+	NUM_TECHNIQUES
+};
+
+const char* TECHNIQUE_NAMES[NUM_TECHNIQUES] = { "naked single", "hidden single", "naked pair", "pointing", "box/line", "x-wing", "search" };
+
+// result of rating a puzzle
+struct Rating
+{
+	Technique hardest; // hardest technique needed
+	int steps;         // number of times a technique was applied
+};
+
+// values and candidates of a puzzle being solved by the rater
+struct RatingState
+{
+	uint8_t cells[81];
+	uint16_t candidates[81]; // 0 for filled squares
+};
+
+// function to place a value and remove it from the candidates of the squares that see it
+void ratePlace(RatingState& state, int square, int value)
+{
+	int x = square % 9, y = square / 9;
+	uint16_t bit = (uint16_t)(1 << (value - 1));
+	state.cells[square] = (uint8_t)value;
+	state.candidates[square] = 0;
+	for (int i = 0; i < 9; ++i)
+	{
+		state.candidates[unitSquare<3>(y, i)] &= ~bit;
+		state.candidates[unitSquare<3>(9 + x, i)] &= ~bit;
+		state.candidates[unitSquare<3>(18 + boxIndex(x, y), i)] &= ~bit;
+	}
+}
+
+// function to remove a value from a square's candidates (returns true if it was one)
+inline bool rateEliminate(RatingState& state, int square, uint16_t bit)
+{
+	if (!(state.candidates[square] & bit)) return false;
+	state.candidates[square] &= ~bit;
+	return true;
+}
+
+// function to place every naked single (returns true if any was placed)
+bool nakedSingles(RatingState& state, int& steps)
+{
+	bool progress = false;
+	for (int square = 0; square < 81; ++square)
+	{
+		uint16_t free = state.candidates[square];
+		if (free && !(free & (free - 1)))
+		{
+			ratePlace(state, square, lowestBit(free) + 1);
+			++steps;
+			progress = true;
+		}
+	}
+	return progress;
+}
+
+// function to place every hidden single (returns true if any was placed)
+bool hiddenSingles(RatingState& state, int& steps)
+{
+	bool progress = false;
+	for (int unit = 0; unit < 27; ++unit)
+	{
+		// values with exactly one place in the unit
+		unsigned int once = 0, twice = 0;
+		for (int i = 0; i < 9; ++i)
+		{
+			unsigned int free = state.candidates[unitSquare<3>(unit, i)];
+			twice |= once & free;
+			once |= free;
+		}
+		unsigned int single = once & ~twice;
+
+		for (int i = 0; i < 9 && single; ++i)
+		{
+			int square = unitSquare<3>(unit, i);
+			unsigned int found = state.candidates[square] & single;
+			if (!found) continue;
+			ratePlace(state, square, lowestBit(found) + 1);
+			single &= ~found;
+			++steps;
+			progress = true;
+		}
+	}
+	return progress;
+}
+
+// function to apply the first naked pair that removes a candidate (returns true if one did)
+bool nakedPair(RatingState& state, int& steps)
+{
+	for (int unit = 0; unit < 27; ++unit)
+		for (int i = 0; i < 9; ++i)
+		{
+			uint16_t pair = state.candidates[unitSquare<3>(unit, i)];
+			if (bitCount(pair) != 2) continue;
+			for (int j = i + 1; j < 9; ++j)
+			{
+				if (state.candidates[unitSquare<3>(unit, j)] != pair) continue;
+
+				bool progress = false;
+				for (int k = 0; k < 9; ++k)
+				{
+					int square = unitSquare<3>(unit, k);
+					if (k == i || k == j || !(state.candidates[square] & pair)) continue;
+					state.candidates[square] &= ~pair;
+					progress = true;
+				}
+				if (progress)
+				{
+					++steps;
+					return true;
+				}
+			}
+		}
+	return false;
+}
+
+// function to apply the first locked candidate (pointing, or box/line when boxLine is set) that removes a candidate
+// (returns true if one did)
+bool lockedCandidate(RatingState& state, bool boxLine, int& steps)
+{
+	for (int value = 1; value <= 9; ++value)
+	{
+		uint16_t bit = (uint16_t)(1 << (value - 1));
+
+		// the source unit is a subgrid for pointing and a row or column for box/line
+		for (int unit = boxLine ? 0 : 18; unit < (boxLine ? 18 : 27); ++unit)
+		{
+			int rows = 0, cols = 0, boxes = 0;
+			for (int i = 0; i < 9; ++i)
+			{
+				int square = unitSquare<3>(unit, i);
+				if (!(state.candidates[square] & bit)) continue;
+				int x = square % 9, y = square / 9;
+				rows |= 1 << y;
+				cols |= 1 << x;
+				boxes |= 1 << boxIndex(x, y);
+			}
+			if (!rows) continue;
+
+			// the units the value is confined to, other than the source unit
+			int targets[2];
+			int numTargets = 0;
+			if (boxLine)
+			{
+				if (bitCount(boxes) == 1) targets[numTargets++] = 18 + lowestBit(boxes);
+			}
+			else
+			{
+				if (bitCount(rows) == 1) targets[numTargets++] = lowestBit(rows);
+				if (bitCount(cols) == 1) targets[numTargets++] = 9 + lowestBit(cols);
+			}
+
+			for (int t = 0; t < numTargets; ++t)
+			{
+				bool progress = false;
+				for (int i = 0; i < 9; ++i)
+				{
+					int square = unitSquare<3>(targets[t], i);
+					int x = square % 9, y = square / 9;
+					bool inSource = boxLine ? (unit < 9 ? y == unit : x == unit - 9) : boxIndex(x, y) == unit - 18;
+					if (!inSource) progress |= rateEliminate(state, square, bit);
+				}
+				if (progress)
+				{
+					++steps;
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// function to apply the first x-wing that removes a candidate (returns true if one did)
+bool xWing(RatingState& state, int& steps)
+{
+	for (int value = 1; value <= 9; ++value)
+	{
+		uint16_t bit = (uint16_t)(1 << (value - 1));
+
+		// base units are rows (cover units columns), then columns (cover units rows)
+		for (int base = 0; base < 18; base += 9)
+		{
+			int places[9];
+			for (int line = 0; line < 9; ++line)
+			{
+				places[line] = 0;
+				for (int i = 0; i < 9; ++i)
+					if (state.candidates[unitSquare<3>(base + line, i)] & bit) places[line] |= 1 << i;
+			}
+
+			for (int a = 0; a < 9; ++a)
+			{
+				if (bitCount(places[a]) != 2) continue;
+				for (int b = a + 1; b < 9; ++b)
+				{
+					if (places[b] != places[a]) continue;
+
+					bool progress = false;
+					int cover = 9 - base; // columns when the base units are rows, and rows otherwise
+					for (int mask = places[a]; mask; mask &= mask - 1)
+						for (int line = 0; line < 9; ++line)
+							if (line != a && line != b) progress |= rateEliminate(state, unitSquare<3>(cover + lowestBit(mask), line), bit);
+					if (progress)
+					{
+						++steps;
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// function to rate the puzzle on a board (only its starting squares count)
+Rating ratePuzzle(const Board& board)
+{
+	RatingState state;
+	Board puzzle = board;
+	for (int square = 0; square < 81; ++square)
+		if (!isGiven(puzzle, square)) puzzle.cells[square] = 0;
+	memcpy(state.cells, puzzle.cells, sizeof(state.cells));
+	allCandidates(puzzle, state.candidates);
+
+	Rating rating = { NAKED_SINGLE, 0 };
+	while (true)
+	{
+		// done when every square is filled (a square with no candidates left means the techniques went wrong,
+		// which only happens when the puzzle has no solution or several)
+		bool full = true, stuck = false;
+		for (int square = 0; square < 81; ++square)
+		{
+			full = full && state.cells[square];
+			stuck = stuck || (!state.cells[square] && !state.candidates[square]);
+		}
+		if (full) return rating;
+		if (stuck) break;
+
+		// always use the simplest technique that makes progress
+		Technique used;
+		if (nakedSingles(state, rating.steps)) used = NAKED_SINGLE;
+		else if (hiddenSingles(state, rating.steps)) used = HIDDEN_SINGLE;
+		else if (nakedPair(state, rating.steps)) used = NAKED_PAIR;
+		else if (lockedCandidate(state, false, rating.steps)) used = POINTING;
+		else if (lockedCandidate(state, true, rating.steps)) used = BOX_LINE;
+		else if (xWing(state, rating.steps)) used = X_WING;
+		else break;
+		if (used > rating.hardest) rating.hardest = used;
+	}
+
+	rating.hardest = SEARCH;
+	return rating;
+}
+
+// number of puzzles generated for a difficulty before settling for one that rates differently
+const int RATING_ATTEMPTS = 20;
+
+// function to get the difficulty of a rating: easy puzzles fall to naked singles alone, medium ones also need
+// hidden singles, and hard ones need at least a naked pair (or guessing)
+string ratingDifficulty(const Rating& rating)
+{
+	if (rating.hardest == NAKED_SINGLE) return "easy";
+	if (rating.hardest == HIDDEN_SINGLE) return "medium";
+	return "hard";
+}
+
+// PUZZLE BANK
+//
+// a bank of puzzles already known to have exactly one solution, grouped by their rated difficulty. a new puzzle is a random
+// symmetry of a banked one, which has the same number of solutions and starting squares, so it is unique and
+// of the same difficulty by construction and takes no search at all.
+
+const char* PUZZLE_BANK_FILE = "bank.txt";
+
+map<string, vector<Board>> puzzleBank; // difficulty -> puzzles (starting squares only)
+bool bankChanged = false;              // puzzles were added since the bank file was loaded
+
+// function to pick a random order of the 9 rows (or columns) that keeps the bands (or stacks) together
+void randomLineOrder(int lines[9])
+{
+	int bands = randomInt(6);
+	for (int i = 0; i < 3; ++i)
+	{
+		int within = randomInt(6);
+		for (int j = 0; j < 3; ++j)
+			lines[i * 3 + j] = ORDERS_OF_3[bands][i] * 3 + ORDERS_OF_3[within][j];
+	}
+}
+
+// function to apply a random symmetry to a puzzle (relabel the values, reorder the rows and columns, and maybe transpose)
+void randomSymmetry(const Board& puzzle, Board& result)
+{
+	int rows[9], cols[9];
+	randomLineOrder(rows);
+	randomLineOrder(cols);
+	bool transpose = randomInt(2) == 1;
+
+	uint8_t labels[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	for (int i = 9; i > 1; --i)
+		swap(labels[i], labels[1 + randomInt(i)]);
+
+	clearBoard(result);
+	for (int y = 0; y < 9; ++y)
+		for (int x = 0; x < 9; ++x)
+		{
+			int source = transpose ? squareIndex(rows[y], cols[x]) : squareIndex(cols[x], rows[y]);
+			int square = squareIndex(x, y);
+			result.cells[square] = labels[puzzle.cells[source]];
+			setGiven(result, square, isGiven(puzzle, source));
+		}
+}
+
+// function to add a puzzle (its starting squares) to the bank, under the difficulty it rates as
+// the caller makes sure it has exactly one solution
+void addToBank(const Board& board)
+{
+	Board puzzle = board;
+	for (int square = 0; square < 81; ++square)
+		if (!isGiven(puzzle, square)) puzzle.cells[square] = 0;
+
+	puzzleBank[ratingDifficulty(ratePuzzle(puzzle))].push_back(puzzle);
+	bankChanged = true;
+}
+
+// function to make a new puzzle of a difficulty from the bank
+// returns false if the bank has no puzzles of that difficulty
+bool bankPuzzle(Board& board, string difficulty)
+{
+	auto found = puzzleBank.find(difficulty);
+	if (found == puzzleBank.end() || found->second.empty()) return false;
+
+	const vector<Board>& puzzles = found->second;
+	randomSymmetry(puzzles[randomInt((int)puzzles.size())], board);
+	return true;
+}
+
+// function to add the puzzles in a file (one line each) to the bank, checking that each one has exactly one solution
+// returns the number of puzzles added, or -1 if the file can't be opened
+int loadBank(string filename)
+{
+	ifstream fin(filename);
+	if (fin.fail()) return -1;
+
+	size_t before = 0;
+	for (auto& difficulty : puzzleBank) before += difficulty.second.size();
+
+	string line;
+	while (getline(fin, line))
+	{
+		Board puzzle;
+		if (fromLine(line.c_str(), (int)line.length(), puzzle) && countSolutions(puzzle, 2) == 1) addToBank(puzzle);
+	}
+	fin.close();
+
+	// the loaded puzzles are already in the file
+	bankChanged = false;
+
+	size_t after = 0;
+	for (auto& difficulty : puzzleBank) after += difficulty.second.size();
+	return (int)(after - before);
+}
+
+// function to save every puzzle in the bank (one line each)
+bool saveBank(string filename)
+{
+	ofstream fout(filename);
+	if (fout.fail()) return false;
+
+	for (auto& difficulty : puzzleBank)
+		for (const Board& puzzle : difficulty.second)
+			fout << toLine(puzzle) << '\n';
+
+	bool written = !fout.fail();
+	fout.close();
+	if (written) bankChanged = false;
+	return written;
+}
+
+// BATCH SOLVING
+//
+// puzzles are solved BATCH_LANES at a time by stepping every board through naked and hidden single
+// propagation together. the batch is stored as structure of arrays ([square][lane]), so each step is a
+// short fixed-length loop over the lanes with no branches, which the compiler turns into vector code.
+// boards that propagation can't finish are handed to the normal search.
+
+// number of boards stepped through propagation together (16 x 16 bits fills an AVX2 register)
+const int BATCH_LANES = 16;
+
+// a batch of boards; every value is stored as its bit, and each lane holds one board
+struct BoardBatch
+{
+	uint16_t bits[81][BATCH_LANES];  // bit of the value in each square (0 for empty squares)
+	uint16_t rows[9][BATCH_LANES];   // bits used in each row, column and subgrid
+	uint16_t cols[9][BATCH_LANES];
+	uint16_t boxes[9][BATCH_LANES];
+	uint16_t live[BATCH_LANES];      // 0xFFFF while a board has no contradiction, 0 once it has
+};
+
+// function to load up to BATCH_LANES boards into a batch (unused lanes start out dead)
+void loadBatch(BoardBatch& batch, const Board boards[], int count)
+{
+	memset(&batch, 0, sizeof(batch));
+	for (int k = 0; k < count; ++k)
+	{
+		batch.live[k] = 0xFFFF;
+		for (int square = 0; square < 81; ++square)
+		{
+			if (boards[k].cells[square] == 0) continue;
+
+			int x = square % 9, y = square / 9, box = boxIndex(x, y);
+			uint16_t bit = (uint16_t)(1u << (boards[k].cells[square] - 1));
+
+			// starting squares that conflict make the board unsolvable
+			if ((batch.rows[y][k] | batch.cols[x][k] | batch.boxes[box][k]) & bit) batch.live[k] = 0;
+			batch.bits[square][k] = bit;
+			batch.rows[y][k] |= bit;
+			batch.cols[x][k] |= bit;
+			batch.boxes[box][k] |= bit;
+		}
+	}
+}
+
+// function to turn a condition into a lane mask (all ones if it holds, otherwise 0)
+FORCE_INLINE uint16_t laneMask(bool condition)
+{
+	return (uint16_t)-(int)condition;
+}
+
+// function to get a mask of the lanes whose entry in an array is non-zero
+FORCE_INLINE uint16_t activeLanes(const uint16_t values[BATCH_LANES])
+{
+	uint16_t lanes = 0;
+	for (int k = 0; k < BATCH_LANES; ++k)
+		if (values[k]) lanes |= (uint16_t)(1u << k);
+	return lanes;
+}
+
+// function to place naked singles in every board of a batch, one pass over the squares
+// returns a mask of the lanes that placed anything
+// (the lane loops only use masks, never branches, so that they compile to vector code)
+FORCE_INLINE uint16_t nakedSinglesBatch(BoardBatch& batch)
+{
+	uint16_t progress[BATCH_LANES] = {};
+	for (int square = 0; square < 81; ++square)
+	{
+		int x = square % 9, y = square / 9, box = boxIndex(x, y);
+		for (int k = 0; k < BATCH_LANES; ++k)
+		{
+			uint16_t empty = laneMask(batch.bits[square][k] == 0);
+			uint16_t free = ~(batch.rows[y][k] | batch.cols[x][k] | batch.boxes[box][k]) & ALL_VALUES & empty;
+
+			// an empty square with no candidates is a contradiction
+			batch.live[k] &= ~(laneMask(free == 0) & empty);
+
+			// place the value if it is the only candidate
+			uint16_t bit = free & laneMask((free & (free - 1)) == 0) & batch.live[k];
+			batch.bits[square][k] |= bit;
+			batch.rows[y][k] |= bit;
+			batch.cols[x][k] |= bit;
+			batch.boxes[box][k] |= bit;
+			progress[k] |= bit;
+		}
+	}
+	return activeLanes(progress);
+}
+
+// function to place hidden singles in every board of a batch, one pass over the units
+// returns a mask of the lanes that placed anything
+FORCE_INLINE uint16_t hiddenSinglesBatch(BoardBatch& batch)
+{
+	uint16_t progress[BATCH_LANES] = {};
+	for (int unit = 0; unit < 27; ++unit)
+	{
+		// values that fit in exactly one square of the unit
+		uint16_t once[BATCH_LANES] = {}, twice[BATCH_LANES] = {}, used[BATCH_LANES] = {};
+		for (int i = 0; i < 9; ++i)
+		{
+			int square = unitSquare<3>(unit, i);
+			int x = square % 9, y = square / 9, box = boxIndex(x, y);
+			for (int k = 0; k < BATCH_LANES; ++k)
+			{
+				uint16_t bit = batch.bits[square][k];
+				uint16_t free = ~(batch.rows[y][k] | batch.cols[x][k] | batch.boxes[box][k]) & ALL_VALUES & laneMask(bit == 0);
+				twice[k] |= once[k] & free;
+				once[k] |= free;
+				used[k] |= bit;
+			}
+		}
+
+		uint16_t hidden[BATCH_LANES];
+		for (int k = 0; k < BATCH_LANES; ++k)
+		{
+			// every value must have somewhere to go
+			batch.live[k] &= laneMask((used[k] | once[k]) == ALL_VALUES);
+			hidden[k] = once[k] & ~twice[k] & batch.live[k];
+		}
+
+		for (int i = 0; i < 9; ++i)
+		{
+			int square = unitSquare<3>(unit, i);
+			int x = square % 9, y = square / 9, box = boxIndex(x, y);
+			for (int k = 0; k < BATCH_LANES; ++k)
+			{
+				uint16_t free = ~(batch.rows[y][k] | batch.cols[x][k] | batch.boxes[box][k]) & ALL_VALUES & laneMask(batch.bits[square][k] == 0);
+				uint16_t place = free & hidden[k];
+
+				// two values that each have to go in the same square is a contradiction
+				batch.live[k] &= laneMask((place & (place - 1)) == 0);
+				place &= batch.live[k];
+
+				batch.bits[square][k] |= place;
+				batch.rows[y][k] |= place;
+				batch.cols[x][k] |= place;
+				batch.boxes[box][k] |= place;
+				progress[k] |= place;
+			}
+		}
+	}
+	return activeLanes(progress);
+}
+
+// function to propagate every board of a batch until none of them makes progress
+FORCE_INLINE void propagateLanes(BoardBatch& batch)
+{
+	bool progress = true;
+	while (progress) progress = (nakedSinglesBatch(batch) | hiddenSinglesBatch(batch)) != 0;
+}
+
+// the propagation loop built for the baseline instruction set, and for AVX2 (all 16 lanes in one register)
+void propagateBatchDefault(BoardBatch& batch)
+{
+	propagateLanes(batch);
+}
+
+#if SIMD_KERNELS
+SIMD_TARGET("avx2")
+void propagateBatchAVX2(BoardBatch& batch)
+{
+	propagateLanes(batch);
+}
+#endif
+
+// function to pick the propagation loop for the CPU
+void (*choosePropagateBatch())(BoardBatch&)
+{
+#if SIMD_KERNELS
+	if (hasAVX2()) return propagateBatchAVX2;
+#endif
+	return propagateBatchDefault;
+}
+
+// propagation loop used by solveBatch()
+void (*propagateBatch)(BoardBatch& batch) = choosePropagateBatch();
+
+// function to solve many boards, propagating BATCH_LANES of them at a time in lockstep
+// boards that stall are finished by solveLimited(); solved[i] is set for each board; returns the number solved
+int solveBatch(Board boards[], int count, bool solved[])
+{
+	STAT(PhaseTimer timer(PHASE_SOLVE));
+
+	int numSolved = 0;
+	BoardBatch batch;
+	for (int first = 0; first < count; first += BATCH_LANES)
+	{
+		int lanes = count - first < BATCH_LANES ? count - first : BATCH_LANES;
+		loadBatch(batch, boards + first, lanes);
+
+		propagateBatch(batch);
+
+		for (int k = 0; k < lanes; ++k)
+		{
+			Board& board = boards[first + k];
+			solved[first + k] = false;
+			if (!batch.live[k]) continue;
+
+			// copy the propagated values back (starting squares keep their marks)
+			bool full = true;
+			for (int square = 0; square < 81; ++square)
+			{
+				uint16_t bit = batch.bits[square][k];
+				board.cells[square] = bit ? (uint8_t)(lowestBit(bit) + 1) : 0;
+				full = full && bit;
+			}
+
+			// search the boards that propagation alone couldn't finish
+			solved[first + k] = full || solveLimited(board);
+			if (solved[first + k]) ++numSolved;
+		}
+	}
+	return numSolved;
+}
+
+// function to reduce a full board while ensuring solution uniqueness (re-solving the board at every step)
+bool generateNaive(Board& board, int numEntries)
+{
+	STAT(DepthGuard depth);
+
+	// if there are multiple solutions, then backtrack
+	Board tempBoard = board;
+
+	int numSolutions = 0;
+	STAT(++stats.uniquenessChecks);
+	if (multiSolve(tempBoard, numSolutions)) return 0;
+
+	// make a list of all non-empty squares
+	int xList[81];
+	int yList[81];
+	int numNonEmpties = 0;
+
+	for (int x = 0; x < 9; ++x)
+		for (int y = 0; y < 9; ++y)
+			if (board.cells[squareIndex(x, y)] != 0)
+			{
+				xList[numNonEmpties] = x;
+				yList[numNonEmpties] = y;
+				++numNonEmpties;
+			}
+
+	// if we have removed enough entries, the we were done
+	if (numNonEmpties <= numEntries) return true;
+
+	// iterate through all non-empty squares
+	while (numNonEmpties)
+	{
+		// pick a random non-empty square
+		int index = randomInt(numNonEmpties);
+		int x = xList[index];
+		int y = yList[index];
+
+		// remove that square from the list
+		--numNonEmpties;
+		for (int i = index; i < numNonEmpties; ++i)
+		{
+			xList[i] = xList[i + 1];
+			yList[i] = yList[i + 1];
+		}
+
+		// save the value of the square and remove it from the board
+		int value = board.cells[squareIndex(x, y)];
+		board.cells[squareIndex(x, y)] = 0;
+
+		// recursively call the generate function
+		if (generateNaive(board, numEntries)) return true;
+
+		// if the call failed, then reset the square to its original value before continuing
+		board.cells[squareIndex(x, y)] = (uint8_t)value;
+	}
+
+	// if no non-empty squares can be safely removed, then we need to backtrack
+	return false;
+}
+
+// function to reduce a full board while ensuring solution uniqueness
+// returns false if it doesn't reach numEntries; with the mrv strategy the board is then left with the fewest
+// starting squares reached before the budget ran out (the naive strategies ignore the budget)
+bool generate(Board& board, int numEntries, const SearchBudget& budget = makeBudget(0, 0))
+{
+	STAT(PhaseTimer timer(PHASE_GENERATE));
+	STAT(++stats.generateCalls);
+
+	if (strategy != MRV) return generateNaive(board, numEntries);
+
+	// the puzzle must start out with exactly one solution
+	if (countSolutions(board, 2) != 1) return false;
+
+	SearchState puzzle;
+	initState(puzzle, board);
+	bool reduced = generateGrid(puzzle, numEntries, budget);
+
+	// copy the reduced puzzle back onto the board
+	copyResult(puzzle, board);
+	return reduced;
+}
+
+// function to reset a board to its initial state
+void reset(Board& board)
+{
+	for (int square = 0; square < 81; ++square)
+		if (!isGiven(board, square)) board.cells[square] = 0;
+}
+
+// function to get the number of starting squares for a difficulty (0 if the difficulty is unknown)
+int numClues(string difficulty)
+{
+	if (difficulty == "easy") return 35 + randomInt(5);
+	if (difficulty == "medium") return 30 + randomInt(5);
+	if (difficulty == "hard") return 25 + randomInt(5);
+	return 0;
+}
+
+// time limit for generating a puzzle in the game
+const double NEW_PUZZLE_MS = 1000;
+
+// function to generate a new puzzle of a given difficulty, within a budget for all of its attempts
+// returns false if the difficulty is unknown, or the budget runs out before a single square can be removed
+bool newPuzzle(Board& board, string difficulty, const SearchBudget& budget = makeBudget(0, 0))
+{
+	if (numClues(difficulty) == 0) return false;
+
+	// generate() can fail to reach the target for some filled boards, and the puzzle may not need the techniques
+	// of the difficulty, so keep trying new ones (settling for any puzzle after RATING_ATTEMPTS tries)
+	// once the budget is spent, settle for the fewest starting squares any attempt reached (the mrv reducer only
+	// stops at puzzles with one solution); the time limit covers every attempt, while the node limit only counts
+	// the removals of each one
+	Board best;
+	int bestEmpty = 0;
+	for (int attempt = 1; ; ++attempt)
+	{
+		// clear the board
+		clearBoard(board);
+
+		// generate a new puzzle
+		randFill(board);
+		SearchBudget removal = restartNodes(budget);
+		bool reduced = generate(board, numClues(difficulty), removal);
+
+		// mark the remaining squares as starting squares
+		int numEmpty = 0;
+		for (int square = 0; square < 81; ++square)
+		{
+			setGiven(board, square, board.cells[square] != 0);
+			if (board.cells[square] == 0) ++numEmpty;
+		}
+
+		if (strategy == MRV && numEmpty > bestEmpty)
+		{
+			best = board;
+			bestEmpty = numEmpty;
+		}
+		if (strategy == MRV && budgetSpent(removal, true))
+		{
+			// a board with no empty squares is no puzzle, so fail if the budget ran out before any could be removed
+			if (bestEmpty == 0) return false;
+			board = best;
+			return true;
+		}
+
+		if (reduced && (attempt >= RATING_ATTEMPTS || ratingDifficulty(ratePuzzle(board)) == difficulty)) return true;
+	}
+}
+
+// function to get the character for a value on any board size ('1' to '9', then 'A' onwards for 10 to 25)
+inline char valueChar(int value)
+{
+	return value < 10 ? char('0' + value) : char('A' + value - 10);
+}
+
+// function to get the value of a character on a board with side values (-1 if it isn't one)
+inline int charValue(char c, int side)
+{
+	int value = -1;
+	if (c >= '1' && c <= '9') value = c - '0';
+	else if (c >= 'A' && c <= 'Z') value = c - 'A' + 10;
+	else if (c >= 'a' && c <= 'z') value = c - 'a' + 10;
+	return value <= side ? value : -1;
+}
+
+// function to write a grid as a single line (rows in order, '.' for empty squares)
+template <int N>
+string gridToLine(const Grid<N>& grid)
+{
+	string line(BoardSize<N>::CELLS, '.');
+	for (int square = 0; square < BoardSize<N>::CELLS; ++square)
+		if (grid.cells[square] != 0) line[square] = valueChar(grid.cells[square]);
+	return line;
+}
+
+// function to read the values of a grid from a line ('0' or '.' for empty squares)
+// returns false if the line is malformed
+template <int N>
+bool gridFromLine(const char* line, size_t length, unsigned char values[])
+{
+	if (length < (size_t)BoardSize<N>::CELLS) return false;
+	for (int square = 0; square < BoardSize<N>::CELLS; ++square)
+	{
+		char c = line[square];
+		if (c == '.' || c == '0') values[square] = 0;
+		else
+		{
+			int value = charValue(c, BoardSize<N>::SIDE);
+			if (value < 0) return false;
+			values[square] = (unsigned char)value;
+		}
+	}
+	return true;
+}
+
+// function to solve one puzzle line of any board size with the MRV solver (an empty line if it can't be solved)
+// returns true if the puzzle was solved
+template <int N>
+bool solveGridLine(const char* line, size_t length, string& output)
+{
+	STAT(PhaseTimer timer(PHASE_SOLVE));
+
+	unsigned char values[BoardSize<N>::CELLS];
+	Grid<N> grid;
+	if (gridFromLine<N>(line, length, values) && initGrid(grid, values) && solveMRV(grid, makeBudget(puzzleMillis, puzzleNodes)))
+	{
+		output += gridToLine(grid);
+		output += '\n';
+		return true;
+	}
+	output += '\n';
+	return false;
+}
+
+// function to check if a line holds a completely and correctly filled board of any size
+template <int N>
+bool isSolvedGridLine(const char* line)
+{
+	unsigned char values[BoardSize<N>::CELLS];
+	Grid<N> grid;
+	return gridFromLine<N>(line, BoardSize<N>::CELLS, values) && initGrid(grid, values) && grid.numEmpty == 0;
+}
+
+// function to generate a puzzle of any board size as a line, within a budget for all of its attempts (an empty
+// string if the budget runs out before a single square can be removed)
+// the number of starting squares for the difficulty is scaled to the size of the board
+template <int N>
+string newGridLine(string difficulty, const SearchBudget& budget)
+{
+	STAT(PhaseTimer timer(PHASE_GENERATE));
+	STAT(++stats.generateCalls);
+
+	// random removal gets stuck at a higher density of starting squares on larger boards
+	// (about 40% on 16x16 and 50% on 25x25), so the targets are raised to stay clear of it
+	const int CELLS = BoardSize<N>::CELLS;
+	int numEntries = numClues(difficulty) * CELLS / 81 + CELLS * (N - 3) * (N - 2) / 20;
+	unsigned char empty[BoardSize<N>::CELLS] = {};
+	Grid<N> grid;
+
+	// generation can fail to reach the target for some filled boards, so keep trying new ones until the budget
+	// runs out, then settle for the fewest starting squares any attempt reached (the time limit covers every
+	// attempt, while the node limit only counts the removals of each one)
+	SearchBudget fill = makeBudget(0, 0);
+	fill.deadline = budget.deadline;
+	Grid<N> best;
+	best.numEmpty = 0;
+	while (true)
+	{
+		initGrid(grid, empty);
+		if (!randFillMRV(grid, fill)) break;
+
+		SearchBudget removal = restartNodes(budget);
+		if (generateGrid(grid, numEntries, removal)) return gridToLine(grid);
+		if (grid.numEmpty > best.numEmpty) best = grid;
+		if (budgetSpent(removal, true)) break;
+	}
+
+	// a grid with no empty squares is no puzzle, so give none if the budget ran out before any could be removed
+	return best.numEmpty > 0 ? gridToLine(best) : "";
+}
+
+// function to generate a puzzle of any board size as a line, within the limits on each puzzle of the batch modes
+template <int N>
+string newGridLine(string difficulty)
+{
+	return newGridLine<N>(difficulty, makeBudget(puzzleMillis, puzzleNodes));
+}
+
+// function to generate a standard puzzle as a line (an empty string if the limits on each puzzle run out first)
+string newPuzzleLine(string difficulty)
+{
+	Board puzzle;
+	if (!newPuzzle(puzzle, difficulty, makeBudget(puzzleMillis, puzzleNodes))) return "";
+	return toLine(puzzle);
+}
+
+// BACKGROUND GENERATION
+//
+// while the game is running, a producer thread keeps a few ready puzzles of every difficulty, so the "new" command
+// never waits for generation. each difficulty has its own bounded queue with one producer (the thread) and one
+// consumer (the game loop), which needs no locks: the producer only moves the tail and the consumer only the head.
+
+const int READY_CAPACITY = 4;
+const char* READY_DIFFICULTIES[3] = { "easy", "medium", "hard" };
+const char* READY_FILE = "ready.txt";
+
+// time limit for each generation attempt of the producer (the batch limits are for the batch modes only)
+const double PRODUCER_PUZZLE_MS = NEW_PUZZLE_MS;
+
+// a bounded queue of puzzles for one producer and one consumer
+struct ReadyQueue
+{
+	Board puzzles[READY_CAPACITY];
+	atomic<unsigned int> head; // count of puzzles taken
+	atomic<unsigned int> tail; // count of puzzles added
+};
+
+ReadyQueue readyQueues[3];
+atomic<bool> stopProducer(false);
+thread producer;
+bool persistReady = true; // save the ready puzzles when the game exits
+
+// function to get the queue for a difficulty (NULL if the difficulty is unknown)
+ReadyQueue* readyQueue(string difficulty)
+{
+	for (int i = 0; i < 3; ++i)
+		if (difficulty == READY_DIFFICULTIES[i]) return &readyQueues[i];
+	return NULL;
+}
+
+// function to add a puzzle to a queue (producer side)
+// returns false if the queue is full
+bool pushReady(ReadyQueue& queue, const Board& puzzle)
+{
+	unsigned int tail = queue.tail.load(memory_order_relaxed);
+	if (tail - queue.head.load(memory_order_acquire) == READY_CAPACITY) return false;
+	queue.puzzles[tail % READY_CAPACITY] = puzzle;
+	queue.tail.store(tail + 1, memory_order_release);
+	return true;
+}
+
+// function to take the oldest puzzle from a queue (consumer side)
+// returns false if the queue is empty
+bool popReady(ReadyQueue& queue, Board& puzzle)
+{
+	unsigned int head = queue.head.load(memory_order_relaxed);
+	if (queue.tail.load(memory_order_acquire) == head) return false;
+	puzzle = queue.puzzles[head % READY_CAPACITY];
+	queue.head.store(head + 1, memory_order_release);
+	return true;
+}
+
+// function to get the number of puzzles in a queue
+int readyCount(const ReadyQueue& queue)
+{
+	return (int)(queue.tail.load(memory_order_acquire) - queue.head.load(memory_order_acquire));
+}
+
+// function run by the producer thread: generate a puzzle for the emptiest queue, or wait while they are all full
+// (it always uses the mrv search, so it doesn't depend on the strategy the player selects)
+void producerLoop(unsigned long long seed)
+{
+	seedRandom(seed);
+	while (!stopProducer.load())
+	{
+		int emptiest = 0;
+		for (int i = 1; i < 3; ++i)
+			if (readyCount(readyQueues[i]) < readyCount(readyQueues[emptiest])) emptiest = i;
+
+		if (readyCount(readyQueues[emptiest]) == READY_CAPACITY)
+		{
+			this_thread::sleep_for(chrono::milliseconds(50));
+			continue;
+		}
+
+		// keep generating until a puzzle rates as the difficulty (or RATING_ATTEMPTS have been tried), then queue the
+		// last one generated; an attempt whose time ran out before it removed a square gives no puzzle
+		string difficulty = READY_DIFFICULTIES[emptiest];
+		Board puzzle;
+		bool generated = false;
+		for (int attempt = 1; attempt <= RATING_ATTEMPTS && !stopProducer.load(); ++attempt)
+		{
+			string line = newGridLine<3>(difficulty, makeBudget(PRODUCER_PUZZLE_MS, 0));
+			Board candidate;
+			if (!fromLine(line.c_str(), (int)line.length(), candidate)) continue;
+			puzzle = candidate;
+			generated = true;
+			if (ratingDifficulty(ratePuzzle(puzzle)) == difficulty) break;
+		}
+		if (generated) pushReady(readyQueues[emptiest], puzzle);
+	}
+
+	// keep the work done on this thread in the statistics
+	lock_guard<mutex> guard(workerStatsLock);
+	addStats(workerStats, stats);
+}
+
+// function to start the producer thread
+void startProducer(unsigned long long seed)
+{
+	stopProducer = false;
+	producer = thread(producerLoop, seed);
+}
+
+// function to stop the producer thread (waits for the puzzle it is working on)
+void stopProducerThread()
+{
+	if (!producer.joinable()) return;
+	stopProducer = true;
+	producer.join();
+}
+
+// function to save the ready puzzles (one line each, with its difficulty)
+bool saveReady(string filename)
+{
+	ofstream fout(filename);
+	if (fout.fail()) return false;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const ReadyQueue& queue = readyQueues[i];
+		unsigned int tail = queue.tail.load(memory_order_acquire);
+		for (unsigned int j = queue.head.load(memory_order_acquire); j != tail; ++j)
+			fout << READY_DIFFICULTIES[i] << ' ' << toLine(queue.puzzles[j % READY_CAPACITY]) << '\n';
+	}
+
+	bool written = !fout.fail();
+	fout.close();
+	return written;
+}
+
+// function to load saved ready puzzles into the queues (before the producer starts); lines that don't hold a
+// puzzle with exactly one solution are skipped
+bool loadReady(string filename)
+{
+	ifstream fin(filename);
+	if (fin.fail()) return false;
+
+	string difficulty, line;
+	while (fin >> difficulty >> line)
+	{
+		ReadyQueue* queue = readyQueue(difficulty);
+		Board puzzle;
+		if (queue && fromLine(line.c_str(), (int)line.length(), puzzle) && countSolutions(puzzle, 2) == 1)
+			pushReady(*queue, puzzle);
+	}
+
+	fin.close();
+	return true;
+}
+
+// function to make a new puzzle line of a difficulty from the bank (for batch generation; the bank must have puzzles of that difficulty)
+string bankPuzzleLine(string difficulty)
+{
+	Board puzzle;
+	bankPuzzle(puzzle, difficulty);
+	return toLine(puzzle);
+}
+
+// function types for the parts of the batch modes that depend on the board size
+typedef bool (*LineSolver)(const char* line, size_t length, string& output);
+typedef bool (*LineChecker)(const char* line);
+typedef string (*PuzzleMaker)(string difficulty);
+
+// size of the chunks the batch solver reads and writes
+const size_t IO_CHUNK = 1 << 20;
+
+// number of lines the batch modes hand to a solver at once
+const int LINE_GROUP = 4 * BATCH_LANES;
+
+// function type for solving a group of puzzle lines, appending one solution line for each
+typedef long long (*LinesSolver)(const char* const lines[], const size_t lengths[], int count, string& output);
+
+// function to solve a group of lines one at a time with a single line solver
+// returns the number of puzzles solved
+template <LineSolver SOLVE>
+long long solveEachLine(const char* const lines[], const size_t lengths[], int count, string& output)
+{
+	long long numSolved = 0;
+	for (int i = 0; i < count; ++i)
+		if (SOLVE(lines[i], lengths[i], output)) ++numSolved;
+	return numSolved;
+}
+
+// function to solve a group of standard puzzle lines with solveBatch() and append their solution lines (an empty line if one can't be solved)
+// returns the number of puzzles solved
+long long solveLines(const char* const lines[], const size_t lengths[], int count, string& output)
+{
+	Board puzzles[LINE_GROUP];
+	bool wellFormed[LINE_GROUP];
+	bool solved[LINE_GROUP];
+
+	long long numSolved = 0;
+	for (int first = 0; first < count; first += LINE_GROUP)
+	{
+		int numLines = count - first < LINE_GROUP ? count - first : LINE_GROUP;
+
+		// malformed lines get no board
+		int numPuzzles = 0;
+		for (int i = 0; i < numLines; ++i)
+		{
+			wellFormed[i] = fromLine(lines[first + i], (int)lengths[first + i], puzzles[numPuzzles]);
+			if (wellFormed[i]) ++numPuzzles;
+		}
+
+		numSolved += solveBatch(puzzles, numPuzzles, solved);
+
+		int next = 0;
+		for (int i = 0; i < numLines; ++i)
+		{
+			if (wellFormed[i])
+			{
+				if (solved[next]) output += toLine(puzzles[next]);
+				++next;
+			}
+			output += '\n';
+		}
+	}
+	return numSolved;
+}
+
+// canonical forms of the puzzles --dedup has written
+PuzzleSet seenPuzzles;
+
+// fewest starting squares a puzzle with one solution can have
+const int MIN_GIVENS = 17;
+
+// function to copy the lines of puzzles that aren't a symmetry of an earlier puzzle to the output
+// puzzles are compared by their canonical form (looked up by its hash); lines that are malformed, have fewer than
+// MIN_GIVENS starting squares or have conflicting ones are dropped; returns the number of lines written
+long long dedupLines(const char* const lines[], const size_t lengths[], int count, string& output)
+{
+	long long numWritten = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		Board puzzle, canonical;
+		if (!fromLine(lines[i], (int)lengths[i], puzzle)) continue;
+
+		int numGivens = 0;
+		for (int square = 0; square < 81; ++square)
+			if (puzzle.cells[square] != 0) ++numGivens;
+		SearchState state;
+		if (numGivens < MIN_GIVENS || !initState(state, puzzle)) continue;
+
+		// if too many symmetries tie, the puzzle itself is the key (it still matches exact repeats)
+		if (!canonicalForm(puzzle, canonical)) canonical = puzzle;
+		if (!insertPuzzle(seenPuzzles, canonical, givensHash(canonical))) continue;
+
+		output.append(lines[i], lengths[i]);
+		output += '\n';
+		++numWritten;
+	}
+	return numWritten;
+}
+
+// function to rate puzzle lines, appending the hardest technique each one needs and its number of steps
+// (an empty line for a malformed line); returns the number of puzzles rated
+long long rateLines(const char* const lines[], const size_t lengths[], int count, string& output)
+{
+	long long numRated = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		Board puzzle;
+		if (fromLine(lines[i], (int)lengths[i], puzzle))
+		{
+			Rating rating = ratePuzzle(puzzle);
+			output += TECHNIQUE_NAMES[rating.hardest];
+			output += ' ';
+			output += to_string(rating.steps);
+			++numRated;
+		}
+		output += '\n';
+	}
+	return numRated;
+}
+
+// function to solve every puzzle in a stream (one line each), writing one solution line per puzzle
+// returns the number of puzzles read; numSolved is set to the number that were solved
+long long solveStream(istream& in, ostream& out, LinesSolver solver, long long& numSolved)
+{
+	vector<char> buffer(IO_CHUNK);
+	size_t used = 0;
+	string output;
+	output.reserve(IO_CHUNK + 128);
+
+	long long numPuzzles = 0;
+	numSolved = 0;
+
+	// lines waiting to be solved (they point into the buffer, so they are solved before it changes)
+	const char* group[LINE_GROUP];
+	size_t lengths[LINE_GROUP];
+	int groupSize = 0;
+	auto solveGroup = [&]()
+	{
+		numSolved += solver(group, lengths, groupSize, output);
+		groupSize = 0;
+
+		// write the output in large chunks
+		if (output.size() >= IO_CHUNK)
+		{
+			out.write(output.data(), output.size());
+			output.clear();
+		}
+	};
+
+	bool done = false;
+	while (!done)
+	{
+		// fill the rest of the buffer
+		in.read(&buffer[used], buffer.size() - used);
+		size_t count = (size_t)in.gcount();
+		used += count;
+		done = count == 0;
+
+		// process every complete line (and the last line of the input, even without a newline)
+		size_t start = 0;
+		while (start < used)
+		{
+			size_t end = start;
+			while (end < used && buffer[end] != '\n') ++end;
+
+			// wait for the rest of an incomplete line (unless it fills the whole buffer)
+			if (end == used && !done && !(start == 0 && used == buffer.size())) break;
+
+			size_t length = end - start;
+			if (length > 0 && buffer[start + length - 1] == '\r') --length;
+			if (length > 0)
+			{
+				++numPuzzles;
+				group[groupSize] = &buffer[start];
+				lengths[groupSize] = length;
+				if (++groupSize == LINE_GROUP) solveGroup();
+			}
+			start = end + 1;
+		}
+		if (groupSize > 0) solveGroup();
+
+		// move the partial line at the end of the buffer to the front
+		if (start < used) memmove(&buffer[0], &buffer[start], used - start);
+		used = start < used ? used - start : 0;
+	}
+
+	out.write(output.data(), output.size());
+	out.flush();
+	return numPuzzles;
+}
+
+// number of records handed to a worker at a time
+const size_t RECORDS_PER_RANGE = 4096;
+
+// a memory mapped file (read only)
+struct MappedFile
+{
+	const char* data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int file;
+#endif
+};
 
-		// remove that square from the list
-		--numNonEmpties;
-		for (int i = index; i < numNonEmpties; ++i)
+// function to unmap a memory mapped file
+void unmapFile(MappedFile& mapped)
+{
+#ifdef _WIN32
+	if (mapped.data) UnmapViewOfFile(mapped.data);
+	if (mapped.mapping) CloseHandle(mapped.mapping);
+	if (mapped.file != INVALID_HANDLE_VALUE) CloseHandle(mapped.file);
+	mapped.mapping = NULL;
+	mapped.file = INVALID_HANDLE_VALUE;
+#else
+	if (mapped.data) munmap((void*)mapped.data, mapped.size);
+	if (mapped.file >= 0) close(mapped.file);
+	mapped.file = -1;
+#endif
+	mapped.data = NULL;
+	mapped.size = 0;
+}
+
+// function to memory map a whole file for reading (sequential if it will be read front to back)
+// returns false if the file can't be mapped or is empty
+bool mapFile(string filename, MappedFile& mapped, bool sequential)
+{
+	mapped.data = NULL;
+	mapped.size = 0;
+
+#ifdef _WIN32
+	mapped.mapping = NULL;
+	mapped.file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+		sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mapped.file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mapped.file, &size) || size.QuadPart == 0)
+	{
+		unmapFile(mapped);
+		return false;
+	}
+	mapped.size = (size_t)size.QuadPart;
+
+	mapped.mapping = CreateFileMappingA(mapped.file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapped.mapping) mapped.data = (const char*)MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!mapped.data)
+	{
+		unmapFile(mapped);
+		return false;
+	}
+#else
+	mapped.file = open(filename.c_str(), O_RDONLY);
+	if (mapped.file < 0) return false;
+
+	struct stat info;
+	if (fstat(mapped.file, &info) != 0 || info.st_size == 0)
+	{
+		unmapFile(mapped);
+		return false;
+	}
+	mapped.size = (size_t)info.st_size;
+
+	void* data = mmap(NULL, mapped.size, PROT_READ, MAP_PRIVATE, mapped.file, 0);
+	if (data == MAP_FAILED)
+	{
+		mapped.size = 0;
+		unmapFile(mapped);
+		return false;
+	}
+	mapped.data = (const char*)data;
+	if (sequential) madvise(data, mapped.size, MADV_SEQUENTIAL);
+#endif
+	return true;
+}
+
+// a memory mapped puzzle corpus of fixed size records
+struct Corpus
+{
+	MappedFile mapped;
+	size_t recordSize; // squares on the board and a newline
+	size_t numRecords;
+};
+
+// function to get a pointer to a record of a corpus (the record is not copied)
+inline const char* corpusRecord(const Corpus& corpus, size_t index)
+{
+	return corpus.mapped.data + index * corpus.recordSize;
+}
+
+// function to close a memory mapped corpus
+void closeCorpus(Corpus& corpus)
+{
+	unmapFile(corpus.mapped);
+	corpus.numRecords = 0;
+}
+
+// function to memory map a corpus file
+// returns false if the file can't be mapped or is not made of whole records of lineLength characters and a newline
+bool openCorpus(string filename, size_t lineLength, Corpus& corpus)
+{
+	corpus.recordSize = lineLength + 1;
+	corpus.numRecords = 0;
+
+	// records are read front to back
+	if (!mapFile(filename, corpus.mapped, true)) return false;
+
+	// the last record may be missing its newline
+	size_t size = corpus.mapped.size;
+	if (corpus.mapped.data[size - 1] != '\n') ++size;
+	if (size % corpus.recordSize != 0)
+	{
+		closeCorpus(corpus);
+		return false;
+	}
+	corpus.numRecords = size / corpus.recordSize;
+
+	// every record has to end in a newline where we expect one (a file of lines of other lengths can still add up to
+	// a whole number of records)
+	for (size_t i = 0; i + 1 < corpus.numRecords; ++i)
+		if (corpusRecord(corpus, i)[corpus.recordSize - 1] != '\n')
 		{
-			xList[i] = xList[i + 1];
-			yList[i] = yList[i + 1];
+			closeCorpus(corpus);
+			return false;
 		}
+	return true;
+}
 
-		// save the value of the square and remove it from the board
-		int value = board[x][y];
-		board[x][y] = 0;
+// output that is produced out of order by several workers but written in order
+struct OrderedOutput
+{
+	mutex lock;
+	map<size_t, string> ready; // finished blocks waiting for an earlier one
+	size_t next;               // index of the next block to write
+};
 
-		// recursively call the generate function
-		if (generate(board, numEntries)) return true;
+// function to hand in a finished block of output; it is written as soon as every earlier block is written
+void writeInOrder(OrderedOutput& output, size_t index, string& text, ostream& out)
+{
+	lock_guard<mutex> guard(output.lock);
+	output.ready[index].swap(text);
+	while (!output.ready.empty() && output.ready.begin()->first == output.next)
+	{
+		string& block = output.ready.begin()->second;
+		out.write(block.data(), block.size());
+		output.ready.erase(output.ready.begin());
+		++output.next;
+	}
+}
 
-		// if the call failed, then reset the square to its original value before continuing
-		board[x][y] = value;
+// function to call process(first, last) for ranges of records on several threads
+void forEachRange(size_t numRecords, int numThreads, function<void(size_t, size_t)> process)
+{
+	WorkPool pool;
+	initPool(pool, numThreads);
+	for (size_t first = 0; first < numRecords; first += RECORDS_PER_RANGE)
+	{
+		size_t last = first + RECORDS_PER_RANGE < numRecords ? first + RECORDS_PER_RANGE : numRecords;
+		submit(pool, [&process, first, last]() { process(first, last); });
+	}
+	runPool(pool, NULL);
+}
+
+// function to solve every record of a corpus on several threads, writing the solutions in the same order
+// returns the number of records solved
+long long solveCorpus(const Corpus& corpus, LinesSolver solver, int numThreads, ostream& out)
+{
+	OrderedOutput output;
+	output.next = 0;
+	atomic<long long> numSolved(0);
+
+	forEachRange(corpus.numRecords, numThreads, [&](size_t first, size_t last)
+	{
+		string text;
+		text.reserve((last - first) * corpus.recordSize);
+		long long solved = 0;
+		const char* group[LINE_GROUP];
+		size_t lengths[LINE_GROUP];
+		for (size_t i = first; i < last; i += LINE_GROUP)
+		{
+			int groupSize = last - i < LINE_GROUP ? (int)(last - i) : LINE_GROUP;
+			for (int k = 0; k < groupSize; ++k)
+			{
+				group[k] = corpusRecord(corpus, i + k);
+				lengths[k] = corpus.recordSize - 1;
+			}
+			solved += solver(group, lengths, groupSize, text);
+		}
+
+		numSolved += solved;
+		writeInOrder(output, first / RECORDS_PER_RANGE, text, out);
+	});
+
+	out.flush();
+	return numSolved;
+}
+
+// function to check if a line holds a completely and correctly filled board
+// (every row, column and subgrid has 9 squares, so it is correct exactly when each one holds all 9 values)
+bool isSolvedLine(const char* line)
+{
+	Masks masks;
+	maskKernel->unitMasks((const uint8_t*)line, '0', masks);
+
+	unsigned int full = ALL_VALUES;
+	for (int i = 0; i < 9; ++i)
+		full &= masks.rows[i] & masks.cols[i] & masks.boxes[i];
+	return full == ALL_VALUES;
+}
+
+// function to check every record of a corpus on several threads, writing the line number of each invalid solution
+// returns the number of valid solutions
+long long validateCorpus(const Corpus& corpus, LineChecker check, int numThreads, ostream& out)
+{
+	OrderedOutput output;
+	output.next = 0;
+	atomic<long long> numValid(0);
+
+	forEachRange(corpus.numRecords, numThreads, [&](size_t first, size_t last)
+	{
+		string text;
+		long long valid = 0;
+		for (size_t i = first; i < last; ++i)
+		{
+			if (check(corpusRecord(corpus, i))) ++valid;
+			else text += to_string(i + 1) + '\n';
+		}
+
+		numValid += valid;
+		writeInOrder(output, first / RECORDS_PER_RANGE, text, out);
+	});
+
+	out.flush();
+	return numValid;
+}
+
+// batch mode functions for one board size
+struct BoardFormat
+{
+	int boxSize;        // side of a subgrid (3 for the standard board)
+	size_t lineLength;  // characters in one puzzle line
+	LinesSolver solve;
+	LineChecker check;
+	PuzzleMaker make;
+};
+
+// supported board sizes; the standard board uses the selected strategy, the others always use MRV
+const BoardFormat BOARD_FORMATS[] =
+{
+	{ 2, 16, solveEachLine<solveGridLine<2>>, isSolvedGridLine<2>, newGridLine<2> },
+	{ 3, 81, solveLines, isSolvedLine, newPuzzleLine },
+	{ 4, 256, solveEachLine<solveGridLine<4>>, isSolvedGridLine<4>, newGridLine<4> },
+	{ 5, 625, solveEachLine<solveGridLine<5>>, isSolvedGridLine<5>, newGridLine<5> },
+};
+
+// function to generate many puzzles on several threads, writing each one as a line as soon as it is done
+// (puzzles that run out of their limits without one are left out); returns the number of puzzles written
+long long generateBatch(long long count, string difficulty, PuzzleMaker make, int numThreads, unsigned long long seed, ostream& out)
+{
+	if (numClues(difficulty) == 0 || numThreads < 1) return 0;
+
+	WorkPool pool;
+	initPool(pool, numThreads);
+
+	mutex outputLock;
+	long long written = 0;
+	for (long long i = 0; i < count; ++i)
+		submit(pool, [&]()
+		{
+			string line = make(difficulty);
+			if (line.empty()) return;
+			line += '\n';
+
+			lock_guard<mutex> guard(outputLock);
+			out.write(line.data(), line.size());
+			++written;
+		});
+
+	// every worker gets its own random sequence
+	runPool(pool, [seed](int index) { seedRandom(seed + 0x632BE59BD9B4E019ull * (index + 1)); });
+
+	out.flush();
+	return written;
+}
+
+// SAVED GAME DIRECTORY
+//
+// the names of the saved games, in alphabetical order. the names are stored back to back in one arena and the
+// ordered index only holds where each one is, so adding, finding or removing a name takes O(log n) and never copies
+// the others. the space of removed names is reclaimed once it is more than half of the arena.
+
+const char* DIRECTORY_FILE = "directory.txt"; // written by older versions (the names now come from the save store)
+
+// where a name is in the arena
+struct SavedName
+{
+	mutable uint32_t offset; // moved by compaction, which keeps the order
+	uint32_t length;
+};
+
+vector<char> saveNameArena;
+size_t saveNameGarbage = 0; // bytes of the arena held by removed names
+
+// order of saved names (also compares them with strings, so a string can be looked up without adding it to the arena)
+struct SavedNameOrder
+{
+	typedef void is_transparent;
+
+	static bool less(const char* a, size_t aLength, const char* b, size_t bLength)
+	{
+		int order = memcmp(a, b, aLength < bLength ? aLength : bLength);
+		return order < 0 || (order == 0 && aLength < bLength);
+	}
+	bool operator()(const SavedName& a, const SavedName& b) const
+	{
+		return less(&saveNameArena[a.offset], a.length, &saveNameArena[b.offset], b.length);
+	}
+	bool operator()(const SavedName& a, const string& b) const
+	{
+		return less(&saveNameArena[a.offset], a.length, b.data(), b.length());
+	}
+	bool operator()(const string& a, const SavedName& b) const
+	{
+		return less(a.data(), a.length(), &saveNameArena[b.offset], b.length);
+	}
+};
+
+set<SavedName, SavedNameOrder> savedGames;
+
+// function to get a saved name as a string
+string savedName(const SavedName& name)
+{
+	return string(&saveNameArena[name.offset], name.length);
+}
+
+// function to check if a name is in the directory
+bool hasSave(const string& name)
+{
+	return savedGames.find(name) != savedGames.end();
+}
+
+// function to add a name to the directory (if it isn't there already)
+void addSave(const string& name)
+{
+	if (name.empty() || hasSave(name)) return;
+
+	SavedName entry = { (uint32_t)saveNameArena.size(), (uint32_t)name.length() };
+	saveNameArena.insert(saveNameArena.end(), name.begin(), name.end());
+	savedGames.insert(entry);
+}
+
+// function to remove a name from the directory
+void removeSave(const string& name)
+{
+	auto found = savedGames.find(name);
+	if (found == savedGames.end()) return;
+	saveNameGarbage += found->length;
+	savedGames.erase(found);
+
+	// compact the arena once most of it is garbage (the names are copied in order, so the index stays sorted)
+	if (saveNameGarbage * 2 <= saveNameArena.size()) return;
+	vector<char> arena;
+	arena.reserve(saveNameArena.size() - saveNameGarbage);
+	for (const SavedName& entry : savedGames)
+	{
+		uint32_t offset = (uint32_t)arena.size();
+		arena.insert(arena.end(), saveNameArena.begin() + entry.offset, saveNameArena.begin() + entry.offset + entry.length);
+		entry.offset = offset;
+	}
+	saveNameArena.swap(arena);
+	saveNameGarbage = 0;
+}
+
+// function to get the name at a position in alphabetical order (an empty string if there isn't one)
+string saveAt(int index)
+{
+	if (index < 0 || index >= (int)savedGames.size()) return "";
+	auto entry = savedGames.begin();
+	advance(entry, index);
+	return savedName(*entry);
+}
+
+// function to list the directory, numbered from 1
+void listSaves(ostream& out)
+{
+	int number = 0;
+	for (const SavedName& entry : savedGames)
+		out << ++number << ": " << savedName(entry) << endl;
+}
+
+// function to load the directory file of older versions (a count, then one name per line)
+bool loadDirectory(string filename)
+{
+	ifstream fin(filename);
+	if (fin.fail()) return false;
+
+	int numSaves = 0;
+	fin >> numSaves;
+	string name;
+	for (int i = 0; i < numSaves && fin >> name; ++i)
+		addSave(name);
+
+	fin.close();
+	return true;
+}
+
+// SAVE STORE
+//
+// every saved game is a record in one append-only log file. saving appends the board under its name, and deleting
+// appends a tombstone, so a write never touches earlier records and a crash can at worst cut off the last one
+// (each record has a checksum, and loading stops at the first bad one). an index in memory holds where the latest
+// record of each name is. on startup the log is memory mapped and only scanned for names; a board is unpacked when
+// it is loaded. once most of the log is replaced or deleted records, the live ones are copied to a new log that
+// replaces it.
+//
+// record: checksum (4 bytes, of the rest of the record), kind (1 byte), name length (2 bytes), name, packed board
+// (board records only); numbers are little endian
+
+const char* SAVE_STORE_FILE = "saves.log";
+const char SAVE_STORE_MAGIC[4] = { 'S', 'D', 'K', 'L' };
+const size_t SAVE_RECORD_HEADER = 7;
+const uint64_t COMPACT_MIN_BYTES = 64 * 1024; // don't bother compacting smaller logs
+const char* AUTOSAVE_NAME = "autosave.txt";   // saved on exit
+const char* DEFAULT_SAVE_NAME = "default.txt"; // used by "save" and "load" without a name
+
+// kinds of record
+enum SaveRecordKind
+{
+	SAVE_RECORD_BOARD = 1,
+	SAVE_RECORD_TOMBSTONE = 2
+};
+
+string saveLogFile;                          // file name of the open log
+MappedFile saveLog;                          // the log as it was when it was opened (later records are read from the file)
+ofstream saveLogOut;                         // the log, open for appending
+unordered_map<string, uint64_t> saveOffsets; // name -> offset of its latest board record
+uint64_t saveLogSize = 0;                    // bytes of whole records in the log
+uint64_t saveLiveBytes = 0;                  // bytes of the records in the index
+
+// function to get the checksum of some bytes (32 bit FNV-1a)
+uint32_t recordChecksum(const char* bytes, size_t length)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; ++i)
+		hash = (hash ^ (uint8_t)bytes[i]) * 16777619u;
+	return hash;
+}
+
+// function to get the length of a board record
+inline size_t boardRecordLength(const string& name)
+{
+	return SAVE_RECORD_HEADER + name.length() + PACKED_SIZE;
+}
+
+// function to make a record (board is NULL for a tombstone)
+string makeSaveRecord(const string& name, const Board* board)
+{
+	string record(SAVE_RECORD_HEADER, '\0');
+	record[4] = (char)(board ? SAVE_RECORD_BOARD : SAVE_RECORD_TOMBSTONE);
+	record[5] = (char)(name.length() & 0xFF);
+	record[6] = (char)(name.length() >> 8);
+	record += name;
+	if (board)
+	{
+		PackedBoard packed;
+		packBoard(*board, packed);
+		record.append((const char*)packed.bytes, PACKED_SIZE);
+	}
+
+	uint32_t checksum = recordChecksum(record.data() + 4, record.length() - 4);
+	for (int i = 0; i < 4; ++i) record[i] = (char)(checksum >> (8 * i));
+	return record;
+}
+
+// function to read the record at the start of some bytes
+// returns its length, or 0 if the bytes don't hold a whole record with the right checksum
+size_t parseSaveRecord(const char* bytes, size_t available, int& kind, string& name)
+{
+	if (available < SAVE_RECORD_HEADER) return 0;
+	kind = (uint8_t)bytes[4];
+	size_t nameLength = (uint8_t)bytes[5] | (size_t)(uint8_t)bytes[6] << 8;
+	size_t length = SAVE_RECORD_HEADER + nameLength;
+	if (kind == SAVE_RECORD_BOARD) length += PACKED_SIZE;
+	else if (kind != SAVE_RECORD_TOMBSTONE) return 0;
+	if (available < length) return 0;
+
+	uint32_t checksum = 0;
+	for (int i = 0; i < 4; ++i) checksum |= (uint32_t)(uint8_t)bytes[i] << (8 * i);
+	if (checksum != recordChecksum(bytes + 4, length - 4)) return 0;
+
+	name.assign(bytes + SAVE_RECORD_HEADER, nameLength);
+	return length;
+}
+
+// function to append a record to the log
+bool appendSaveRecord(const string& record)
+{
+	saveLogOut.write(record.data(), record.length());
+	saveLogOut.flush();
+	if (saveLogOut.fail()) return false;
+	saveLogSize += record.length();
+	return true;
+}
+
+// function to get the name of a temporary file next to the log
+string compactLogFile(string filename)
+{
+	return filename + ".tmp";
+}
+
+// function to write a new log holding only the latest record of each name, and replace the old one with it
+bool compactSaveStore();
+
+// function to open the save store in a log file (creating it if there isn't one)
+// a log that ends in a partial or damaged record is compacted, which drops it (unless repair is false)
+bool openSaveStore(string filename, bool repair = true)
+{
+	saveLogFile = filename;
+	saveOffsets.clear();
+	saveLiveBytes = 0;
+	saveLogSize = sizeof(SAVE_STORE_MAGIC);
+
+	// scan the records of an existing log for their names
+	bool damaged = false;
+	if (mapFile(filename, saveLog, true))
+	{
+		if (saveLog.size < sizeof(SAVE_STORE_MAGIC) || memcmp(saveLog.data, SAVE_STORE_MAGIC, sizeof(SAVE_STORE_MAGIC)) != 0)
+		{
+			unmapFile(saveLog);
+			return false;
+		}
+
+		int kind = 0;
+		string name;
+		while (size_t length = parseSaveRecord(saveLog.data + saveLogSize, saveLog.size - saveLogSize, kind, name))
+		{
+			auto found = saveOffsets.find(name);
+			if (found != saveOffsets.end())
+			{
+				saveLiveBytes -= boardRecordLength(name);
+				saveOffsets.erase(found);
+			}
+			if (kind == SAVE_RECORD_BOARD)
+			{
+				saveOffsets[name] = saveLogSize;
+				saveLiveBytes += length;
+			}
+			saveLogSize += length;
+		}
+		damaged = saveLogSize != saveLog.size;
+	}
+	else
+	{
+		// start a new log
+		ofstream fout(filename, ios::binary);
+		fout.write(SAVE_STORE_MAGIC, sizeof(SAVE_STORE_MAGIC));
+		bool written = !fout.fail();
+		fout.close();
+		if (!written) return false;
+	}
+
+	if (damaged) return repair && compactSaveStore();
+
+	saveLogOut.open(filename, ios::binary | ios::app);
+	return !saveLogOut.fail();
+}
+
+// function to close the save store
+void closeSaveStore()
+{
+	if (saveLogOut.is_open()) saveLogOut.close();
+	unmapFile(saveLog);
+}
+
+// function to read the board of the record at an offset in the log
+bool readBoardRecord(uint64_t offset, const string& name, Board& board)
+{
+	size_t length = boardRecordLength(name);
+	const char* bytes = NULL;
+	string buffer;
+
+	// records that were in the log when it was opened are mapped; later ones are read from the file
+	if (saveLog.data && offset + length <= saveLog.size) bytes = saveLog.data + offset;
+	else
+	{
+		ifstream fin(saveLogFile, ios::binary);
+		fin.seekg((streamoff)offset);
+		buffer.resize(length);
+		fin.read(&buffer[0], length);
+		if (fin.gcount() != (streamsize)length) return false;
+		bytes = buffer.data();
+	}
+
+	int kind = 0;
+	string recordName;
+	if (parseSaveRecord(bytes, length, kind, recordName) != length || kind != SAVE_RECORD_BOARD || recordName != name) return false;
+
+	PackedBoard packed;
+	memcpy(packed.bytes, bytes + SAVE_RECORD_HEADER + name.length(), PACKED_SIZE);
+	return unpackBoard(packed, board);
+}
+
+bool compactSaveStore()
+{
+	// copy the live records, in the order they were written
+	vector<pair<uint64_t, string>> live;
+	for (auto& entry : saveOffsets) live.push_back(make_pair(entry.second, entry.first));
+	sort(live.begin(), live.end());
+
+	string tempFile = compactLogFile(saveLogFile);
+	ofstream fout(tempFile, ios::binary);
+	fout.write(SAVE_STORE_MAGIC, sizeof(SAVE_STORE_MAGIC));
+	for (auto& entry : live)
+	{
+		Board board;
+		if (!readBoardRecord(entry.first, entry.second, board)) continue;
+		string record = makeSaveRecord(entry.second, &board);
+		fout.write(record.data(), record.length());
+	}
+	bool written = !fout.fail();
+	fout.close();
+	if (!written)
+	{
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	// replace the old log (which has to be closed first on windows) and open the new one
+	string filename = saveLogFile;
+	closeSaveStore();
+#ifdef _WIN32
+	bool replaced = MoveFileExA(tempFile.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	bool replaced = rename(tempFile.c_str(), filename.c_str()) == 0;
+#endif
+	if (!replaced)
+	{
+		// keep using the old log
+		remove(tempFile.c_str());
+		openSaveStore(filename, false);
+		return false;
+	}
+	return openSaveStore(filename);
+}
+
+// function to compact the save store once the log is big and mostly replaced or deleted records
+void maybeCompactSaveStore()
+{
+	if (saveLogSize >= COMPACT_MIN_BYTES && saveLiveBytes * 2 < saveLogSize) compactSaveStore();
+}
+
+// function to save a game under a name
+bool storeSave(const string& name, const Board& board)
+{
+	if (name.empty() || name.length() > 0xFFFF) return false;
+
+	uint64_t offset = saveLogSize;
+	if (!appendSaveRecord(makeSaveRecord(name, &board))) return false;
+
+	auto found = saveOffsets.find(name);
+	if (found != saveOffsets.end()) saveLiveBytes -= boardRecordLength(name);
+	saveOffsets[name] = offset;
+	saveLiveBytes += boardRecordLength(name);
+
+	maybeCompactSaveStore();
+	return true;
+}
+
+// function to load the game saved under a name
+bool storeLoad(const string& name, Board& board)
+{
+	auto found = saveOffsets.find(name);
+	return found != saveOffsets.end() && readBoardRecord(found->second, name, board);
+}
+
+// function to delete the game saved under a name
+bool storeDelete(const string& name)
+{
+	auto found = saveOffsets.find(name);
+	if (found == saveOffsets.end()) return false;
+	if (!appendSaveRecord(makeSaveRecord(name, NULL))) return false;
+
+	saveLiveBytes -= boardRecordLength(name);
+	saveOffsets.erase(found);
+
+	maybeCompactSaveStore();
+	return true;
+}
+
+// function to copy the saves of older versions (one file per save, listed in the directory file) into the store
+void importSaveFiles()
+{
+	loadDirectory(DIRECTORY_FILE);
+	vector<string> names;
+	for (const SavedName& entry : savedGames) names.push_back(savedName(entry));
+	names.push_back(AUTOSAVE_NAME);
+	names.push_back(DEFAULT_SAVE_NAME);
+
+	for (const string& name : names)
+	{
+		Board saved;
+		if (load(name, saved)) storeSave(name, saved);
 	}
-
-	// if no non-empty squares can be safely removed, then we need to backtrack
-	return false;
 }
 
-// function to reset a board to its initial state
-void reset(int board[9][9])
+// function to load a game from the store, or else from a file (a save of an older version or a puzzle file)
+bool loadGame(const string& name, Board& board)
 {
-	for (int x = 0; x < 9; ++x)
-		for (int y = 0; y < 9; ++y)
-			if (board[x][y] > 0) board[x][y] = 0;
+	return storeLoad(name, board) || load(name, board);
 }
 
-// function to alphebetize an array of strings
-void alphebetize(string strings[], int numStrings)
+// function to fill the directory with the games in the store (the autosave and the default save aren't listed)
+void listStoredSaves()
 {
-	// selection sort
-	for (int i = 0; i < numStrings; ++i)
-	{
-		// determine which element we need to swap with
-		int swapIndex = i;
-		for (int j = i; j < numStrings; ++j)
-		{
-			if (strings[j] < strings[swapIndex])
-				swapIndex = j;
-		}
-
-		// perform the swap
-		string temp = strings[swapIndex];
-		strings[swapIndex] = strings[i];
-		strings[i] = temp;
-	}
+	for (auto& entry : saveOffsets)
+		if (entry.first != AUTOSAVE_NAME && entry.first != DEFAULT_SAVE_NAME) addSave(entry.first);
 }
 
-// signal handler
+// set by the signal handler; the game loop saves and exits when it sees it
+volatile sig_atomic_t exitRequested = 0;
+
+// signal handler (it only asks the game loop to exit, since the signal may have interrupted a save)
 void signalHandler(int signal)
 {
-	// code that runs before exit will go here.
-
-	save("autosave.txt", board); // save the board to an autosave file
-
-	// save contents of the directory
-	ofstream fout("directory.txt");
-	fout << numSaves << endl;
-	for (int i = 0; i < numSaves; ++i)
-		fout << savedGames[i] << endl;
-	fout.close();
+	exitRequested = 1;
+	stopProducer = true;
+}
 
-	// deallocate memory from saved games
-	if (savedGames)
-	{
-		delete[] savedGames;
-		savedGames = NULL;
-	}
+// function to read a line of input, returning false if the game should exit instead
+bool readInput(string& line)
+{
+	if (exitRequested) return false;
+	getline(cin, line);
+	return !exitRequested && !cin.fail();
 }
 
 // menu function
@@ -418,7 +4752,7 @@ string menu()
 
 	// get user input
 	string selection;
-	getline(cin, selection);
+	if (!readInput(selection)) return "exit";
 
 	// process input
 	if (selection == "1" || selection == "Continue Game" || selection == "continue game") return "";
@@ -438,7 +4772,7 @@ string menu()
 			cout << ">> ";
 
 			// get input
-			getline(cin, selection);
+			if (!readInput(selection)) return "exit";
 
 			// process input
 			if (selection == "0" || selection == "Back" || selection == "back") return menu();
@@ -457,12 +4791,11 @@ string menu()
 			// list saved games
 			cout << "Select a file to save to (or enter a new filename):" << endl;
 			cout << "(enter 0 or back to go back to main menu)" << endl << endl;
-			for (int i = 0; i < numSaves; ++i)
-				cout << i + 1 << ": " << savedGames[i] << endl;
+			listSaves(cout);
 			cout << endl << ">> ";
 
 			// get user input
-			getline(cin, selection);
+			if (!readInput(selection)) return "exit";
 			if (selection == "0" || selection == "Back" || selection == "back") return menu();
 
 			// see if the user gave us a number
@@ -476,7 +4809,7 @@ string menu()
 			if (isNumber)
 			{
 				int index = stoi(selection) - 1;
-				if (index < numSaves) selection = savedGames[index];
+				if (index < (int)savedGames.size()) selection = saveAt(index);
 			}
 
 			// return command
@@ -493,12 +4826,11 @@ string menu()
 			// list saved games
 			cout << "Select a file to load:" << endl;
 			cout << "(enter 0 or back to go back to main menu)" << endl << endl;
-			for (int i = 0; i < numSaves; ++i)
-				cout << i + 1 << ": " << savedGames[i] << endl;
+			listSaves(cout);
 			cout << endl << ">> ";
 
 			// get user input
-			getline(cin, selection);
+			if (!readInput(selection)) return "exit";
 			if (selection == "0" || selection == "Back" || selection == "back") return menu();
 
 			// see if the user gave us a number
@@ -512,13 +4844,11 @@ string menu()
 			if (isNumber)
 			{
 				int index = stoi(selection) - 1;
-				if (index < numSaves) selection = savedGames[index];
+				if (index < (int)savedGames.size()) selection = saveAt(index);
 			}
 
 			// check to make sure filename is in the directory before returning
-			bool inDirectory = false;
-			for (int i = 0; i < numSaves; ++i)
-				if (savedGames[i] == selection) return "load " + selection;
+			if (hasSave(selection)) return "load " + selection;
 		}
 	}
 	if (selection == "5" || selection == "Delete Save" || selection == "delete save")
@@ -531,12 +4861,11 @@ string menu()
 			// list saved games
 			cout << "Select a file to delete:" << endl;
 			cout << "(enter 0 or back to go back to main menu)" << endl << endl;
-			for (int i = 0; i < numSaves; ++i)
-				cout << i + 1 << ": " << savedGames[i] << endl;
+			listSaves(cout);
 			cout << endl << ">> ";
 
 			// get user input
-			getline(cin, selection);
+			if (!readInput(selection)) return "exit";
 			if (selection == "0" || selection == "Back" || selection == "back") return menu();
 
 			// see if the user gave us a number
@@ -550,13 +4879,11 @@ string menu()
 			if (isNumber)
 			{
 				int index = stoi(selection) - 1;
-				if (index < numSaves) selection = savedGames[index];
+				if (index < (int)savedGames.size()) selection = saveAt(index);
 			}
 
 			// check to make sure filename is in the directory before returning
-			bool inDirectory = false;
-			for (int i = 0; i < numSaves; ++i)
-				if (savedGames[i] == selection) return "delete " + selection;
+			if (hasSave(selection)) return "delete " + selection;
 		}
 	}
 	if (selection == "6" || selection == "Help" || selection == "help")
@@ -581,28 +4908,44 @@ string menu()
 			cout <<
 				"You can load, save, and delete games directly in the game's console interface with the \"load\"\n"
 				"\"save\" and \"delete\" commands, respectively.  For example, the command \"save saveGame1\" will\n"
-				"save the current board to a file called \"saveGame1.\"  If such a file already exists in the\n"
-				"file directory, it will be saved to that file.  If no such file exists, a new file will be\n"
-				"created.  You can view a list of all available save files with the \"list saves\" command." << endl << endl;
+				"save the current board under the name \"saveGame1,\" replacing any game already saved under\n"
+				"that name.  All saved games are kept together in the file \"saves.log.\"  You can view a list of\n"
+				"your saved games with the \"list saves\" command." << endl << endl;
 			cout <<
 				"You can view the solution to the current puzzle with the \"solve\" command.  If you want to\n"
 				"view the correct value of a particular square, you can use the \"hint\" command.  For example,\n"
-				"the command \"hint f8\" will show the correct value to be placed on square f8." << endl << endl;
+				"the command \"hint f8\" will show the correct value to be placed on square f8.  Solutions are\n"
+				"cached, so hints and solving a puzzle again are instant; \"cache\" shows the cache, \"cache clear\"\n"
+				"empties it, and \"cache persist off\" stops it from being saved between games." << endl << endl;
 			cout <<
 				"You can generate a new puzzle directly in the game's console using the \"new\" command.  For\n"
 				"example, the command \"new medium\" will generate a new puzzle of medium difficulty.  Available\n"
-				"difficulties are \"easy\" \"medium\" and \"hard.\"" << endl << endl;
+				"difficulties are \"easy\" \"medium\" and \"hard.\"  Generated puzzles are kept in a bank, and later\n"
+				"puzzles of the same difficulty are made instantly by shuffling a banked one.  Difficulty is\n"
+				"rated by the hardest technique a puzzle needs (\"rate\" shows it for the current puzzle): easy\n"
+				"puzzles need only naked singles, medium ones hidden singles, and hard ones pairs, pointing,\n"
+				"box/line or x-wings.  While you play, a few puzzles of each difficulty are generated in the\n"
+				"background; \"pregen\" shows how many are ready, and \"pregen persist off\" stops them from\n"
+				"being saved between games." << endl << endl;
+			cout <<
+				"You can choose how the solver searches with the \"strategy\" command.  Available strategies are\n"
+				"\"naive\" \"bitmask\" \"mrv\" (the default) and \"dlx.\"  The \"benchmark\" command solves the current\n"
+				"puzzle with every strategy and shows how long each one took.  The \"threads\" command sets how\n"
+				"many threads the mrv solver may use; for example, \"threads 4\" splits hard puzzles across four\n"
+				"threads.  The \"stats\" command shows how much work the solver and generator have done so far,\n"
+				"and \"stats reset\" clears it." << endl << endl;
 			cout <<
-				"You can undo moves with the \"undo\" command.  You can also redo moves with the \"redo\" command." << endl << endl;
+				"You can undo moves with the \"undo\" command.  You can also redo moves with the \"redo\" command.\n"
+				"Both take an optional number of moves; for example, \"undo 10\" takes back the last ten moves." << endl << endl;
 			cout <<
 				"You can access the main menu using the \"menu\" command." << endl << endl;
 			cout <<
 				"You can exit the game using the \"exit\" command.  When the game exits, your progress will be\n"
-				"saved in an auto-save file that will be loaded the next time the game launches." << endl << endl;
+				"auto-saved in \"saves.log\" and loaded again the next time the game launches." << endl << endl;
 			cout << "To go back to the main menu, enter \"0\" or \"back\":" << endl << endl;
 			cout << ">> ";
 
-			getline(cin, selection);
+			if (!readInput(selection)) return "exit";
 			if (selection == "0" || selection == "Back" || selection == "back") return menu();
 		}
 	}
@@ -612,46 +4955,565 @@ string menu()
 	return menu();
 }
 
+// known hard puzzles for the benchmarks
+const char* HARD_PUZZLES[] =
+{
+	"8..........36......7..9.2...5...7.......457.....1...3...1....68..85...1..9....4..",
+	"..53.....8......2..7..1.5..4....53...1..7...6..32...8..6.5....9..4....3......97..",
+	"1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..",
+};
+
+// puzzles with the minimum of 17 starting squares
+const char* MINIMAL_PUZZLES[] =
+{
+	"6.....8.3.4.7.................5.4.7.3..2.....1.6.......2.....5.....8.6......1....",
+	"48.3............71.2.......7.5....6....2..8.............1.76...3.....4......5....",
+	".......1.4.........2...........5.4.7..8...3....1.9....3..4..2...5.1........8.6...",
+	".......1.4.........2...........5.6.4..8...3....1.9....3..4..2...5.1........8.7...",
+	".......12....35......6...7.7.....3.....4..8..1...........12.....8.....4..5....6..",
+};
+
+// puzzles that make a plain backtracking search take a very long time
+const char* ADVERSARIAL_PUZZLES[] =
+{
+	"..............3.85..1.2.......5.7.....4...1...9.......5......73..2.1........4...9",
+	"....14....3....2...7..........9...3.6.1.............8.2.....1.4....5.6.....7.8...",
+	"4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......",
+	"52...6.........7.13...........4..8..6......5...........418.........3..2...87.....",
+};
+
+// results the benchmarks compute are added here, so that the compiler can't optimize the work away
+volatile long long benchSink = 0;
+
+// a named list of puzzles for the benchmarks
+struct BenchCorpus
+{
+	string name;
+	vector<string> puzzles;
+};
+
+// function to get the time in microseconds since a starting point
+inline double microsSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+// function to write the latency percentiles and throughput of one benchmark as a line of JSON
+void reportBenchmark(ostream& out, string function, string strategy, string corpus, vector<double>& micros, double opsPerSample)
+{
+	if (micros.empty()) return;
+	sort(micros.begin(), micros.end());
+
+	double total = 0;
+	for (size_t i = 0; i < micros.size(); ++i) total += micros[i];
+
+	size_t n = micros.size();
+	out << "{\"function\":\"" << function << "\",\"strategy\":\"" << strategy << "\",\"corpus\":\"" << corpus << "\""
+		<< ",\"samples\":" << n
+		<< ",\"mean_us\":" << total / n
+		<< ",\"p50_us\":" << micros[n / 2]
+		<< ",\"p90_us\":" << micros[n * 9 / 10]
+		<< ",\"p99_us\":" << micros[n * 99 / 100]
+		<< ",\"max_us\":" << micros[n - 1]
+		<< ",\"ops_per_s\":" << (total > 0 ? n * opsPerSample * 1e6 / total : 0)
+		<< "}" << endl;
+}
+
+// function to run every benchmark on fixed-seed corpora, writing one line of JSON per benchmark
+void runBenchmarks(ostream& out, unsigned long long seed)
+{
+	Strategy current = strategy;
+	Strategy strategies[4] = { NAIVE, BITMASK, MRV, DANCING_LINKS };
+
+	// build the corpora (generated puzzles are the same for the same seed)
+	vector<BenchCorpus> corpora(4);
+	corpora[0].name = "easy";
+	corpora[1].name = "hard";
+	corpora[2].name = "minimal";
+	corpora[3].name = "adversarial";
+
+	strategy = MRV;
+	seedRandom(seed);
+	for (int i = 0; i < 100; ++i)
+	{
+		Board puzzle;
+		newPuzzle(puzzle, "easy");
+		corpora[0].puzzles.push_back(toLine(puzzle));
+		newPuzzle(puzzle, "hard");
+		corpora[1].puzzles.push_back(toLine(puzzle));
+	}
+	for (size_t i = 0; i < sizeof(HARD_PUZZLES) / sizeof(HARD_PUZZLES[0]); ++i) corpora[1].puzzles.push_back(HARD_PUZZLES[i]);
+	for (size_t i = 0; i < sizeof(MINIMAL_PUZZLES) / sizeof(MINIMAL_PUZZLES[0]); ++i) corpora[2].puzzles.push_back(MINIMAL_PUZZLES[i]);
+	for (size_t i = 0; i < sizeof(ADVERSARIAL_PUZZLES) / sizeof(ADVERSARIAL_PUZZLES[0]); ++i) corpora[3].puzzles.push_back(ADVERSARIAL_PUZZLES[i]);
+
+	for (size_t c = 0; c < corpora.size(); ++c)
+	{
+		BenchCorpus& corpus = corpora[c];
+
+		// small corpora are repeated to get enough samples for the percentiles
+		int repeat = corpus.puzzles.size() >= 100 ? 1 : 20;
+
+		// isLegal: every value in every square of each puzzle
+		vector<double> micros;
+		for (int r = 0; r < repeat; ++r)
+			for (size_t i = 0; i < corpus.puzzles.size(); ++i)
+			{
+				Board puzzle;
+				fromLine(corpus.puzzles[i].c_str(), 81, puzzle);
+
+				int legal = 0;
+				auto start = chrono::steady_clock::now();
+				for (int x = 0; x < 9; ++x)
+					for (int y = 0; y < 9; ++y)
+						for (int value = 1; value <= 9; ++value)
+							legal += isLegal(puzzle, x, y, value);
+				micros.push_back(microsSince(start));
+				benchSink += legal;
+			}
+		reportBenchmark(out, "isLegal", "-", corpus.name, micros, 729);
+
+		// canonicalForm of each puzzle
+		micros.clear();
+		for (int r = 0; r < repeat; ++r)
+			for (size_t i = 0; i < corpus.puzzles.size(); ++i)
+			{
+				Board puzzle, canonical;
+				fromLine(corpus.puzzles[i].c_str(), 81, puzzle);
+				auto start = chrono::steady_clock::now();
+				canonicalForm(puzzle, canonical);
+				micros.push_back(microsSince(start));
+				benchSink += canonical.cells[80];
+			}
+		reportBenchmark(out, "canonicalForm", "-", corpus.name, micros, 1);
+
+		// ratePuzzle of each puzzle
+		micros.clear();
+		for (int r = 0; r < repeat; ++r)
+			for (size_t i = 0; i < corpus.puzzles.size(); ++i)
+			{
+				Board puzzle;
+				fromLine(corpus.puzzles[i].c_str(), 81, puzzle);
+				auto start = chrono::steady_clock::now();
+				Rating rating = ratePuzzle(puzzle);
+				micros.push_back(microsSince(start));
+				benchSink += rating.steps;
+			}
+		reportBenchmark(out, "ratePuzzle", "-", corpus.name, micros, 1);
+
+		// solve and multiSolve with every strategy
+		for (int s = 0; s < 4; ++s)
+		{
+			// searching the first empty square takes seconds to minutes on these corpora
+			bool firstEmpty = strategies[s] == NAIVE || strategies[s] == BITMASK;
+			if (firstEmpty && (corpus.name == "minimal" || corpus.name == "adversarial")) continue;
+			strategy = strategies[s];
+
+			vector<double> solveMicros, multiMicros;
+			for (int r = 0; r < repeat; ++r)
+				for (size_t i = 0; i < corpus.puzzles.size(); ++i)
+				{
+					Board puzzle;
+					fromLine(corpus.puzzles[i].c_str(), 81, puzzle);
+					auto start = chrono::steady_clock::now();
+					solve(puzzle);
+					solveMicros.push_back(microsSince(start));
+
+					fromLine(corpus.puzzles[i].c_str(), 81, puzzle);
+					int numSolutions = 0;
+					start = chrono::steady_clock::now();
+					multiSolve(puzzle, numSolutions);
+					multiMicros.push_back(microsSince(start));
+				}
+			reportBenchmark(out, "solve", strategyName(strategy), corpus.name, solveMicros, 1);
+			reportBenchmark(out, "multiSolve", strategyName(strategy), corpus.name, multiMicros, 1);
+		}
+
+		// solveBatch on the whole corpus at once (stalled boards fall back to mrv)
+		strategy = MRV;
+		vector<Board> boards(corpus.puzzles.size());
+		vector<char> solved(corpus.puzzles.size());
+		vector<double> batchMicros;
+		for (int r = 0; r < 20 * repeat; ++r)
+		{
+			for (size_t i = 0; i < corpus.puzzles.size(); ++i) fromLine(corpus.puzzles[i].c_str(), 81, boards[i]);
+			auto start = chrono::steady_clock::now();
+			benchSink += solveBatch(&boards[0], (int)boards.size(), (bool*)&solved[0]);
+			batchMicros.push_back(microsSince(start));
+		}
+		reportBenchmark(out, "solveBatch", "mrv", corpus.name, batchMicros, (double)corpus.puzzles.size());
+	}
+
+	// randFill from an empty board with every strategy
+	for (int s = 0; s < 4; ++s)
+	{
+		strategy = strategies[s];
+		seedRandom(seed);
+
+		vector<double> micros;
+		for (int i = 0; i < 200; ++i)
+		{
+			Board filled;
+			clearBoard(filled);
+			auto start = chrono::steady_clock::now();
+			randFill(filled);
+			micros.push_back(microsSince(start));
+		}
+		reportBenchmark(out, "randFill", strategyName(strategy), "empty", micros, 1);
+	}
+
+	// unit masks of solved boards (what validation computes) with every kernel the CPU supports
+	strategy = MRV;
+	seedRandom(seed);
+	vector<string> solved;
+	for (int i = 0; i < 1000; ++i)
+	{
+		Board filled;
+		clearBoard(filled);
+		randFill(filled);
+		solved.push_back(toLine(filled));
+	}
+	for (const MaskKernel& kernel : MASK_KERNELS)
+	{
+		if (!kernel.supported()) continue;
+
+		vector<double> micros;
+		for (int r = 0; r < 100; ++r)
+		{
+			unsigned int full = 0;
+			auto start = chrono::steady_clock::now();
+			for (size_t i = 0; i < solved.size(); ++i)
+			{
+				Masks masks;
+				kernel.unitMasks((const uint8_t*)solved[i].data(), '0', masks);
+				full += masks.rows[i % 9] & masks.cols[i % 9] & masks.boxes[i % 9];
+			}
+			micros.push_back(microsSince(start));
+			benchSink += full;
+		}
+		reportBenchmark(out, "unitMasks", kernel.name, "solved", micros, (double)solved.size());
+	}
+
+	// generate from the same filled boards with the incremental (mrv) and the re-solving (bitmask) reducers
+	string difficulties[3] = { "easy", "medium", "hard" };
+	Strategy reducers[2] = { MRV, BITMASK };
+	for (int d = 0; d < 3; ++d)
+		for (int s = 0; s < 2; ++s)
+		{
+			// the re-solving reducer can backtrack for minutes on hard targets
+			if (reducers[s] == BITMASK && difficulties[d] == "hard") continue;
+			seedRandom(seed);
+
+			vector<double> micros;
+			for (int i = 0; i < 50; ++i)
+			{
+				strategy = MRV;
+				Board puzzle;
+				clearBoard(puzzle);
+				randFill(puzzle);
+				int target = numClues(difficulties[d]);
+
+				strategy = reducers[s];
+				auto start = chrono::steady_clock::now();
+				generate(puzzle, target);
+				micros.push_back(microsSince(start));
+			}
+			reportBenchmark(out, "generate", strategyName(reducers[s]), difficulties[d], micros, 1);
+		}
+
+	strategy = current;
+}
+
+// function to print the command line usage
+void usage()
+{
+	cerr << "usage:" << endl;
+	cerr << "  sudoku                                   play the game" << endl;
+	cerr << "  sudoku --generate COUNT DIFFICULTY       generate puzzles (easy, medium or hard), one per line" << endl;
+	cerr << "  sudoku --solve [FILE]                    solve puzzles from a file or stdin, one per line" << endl;
+	cerr << "  sudoku --validate FILE                   list the line numbers of incorrect solutions in a file" << endl;
+	cerr << "  sudoku --dedup [FILE]                    copy puzzles from a file or stdin, dropping any that are a symmetry of an earlier one" << endl;
+	cerr << "  sudoku --rate [FILE]                     rate puzzles from a file or stdin by the hardest technique each one needs" << endl;
+	cerr << "  sudoku --bench                           benchmark the solver and generator (one JSON line per result)" << endl;
+	cerr << endl;
+	cerr << "options:" << endl;
+	cerr << "  --threads N     number of worker threads (default: number of cores)" << endl;
+	cerr << "  --seed S        random seed (default: current time)" << endl;
+	cerr << "  --output FILE   write results to a file instead of stdout" << endl;
+	cerr << "  --size N        subgrid size for --generate, --solve and --validate: 2 (4x4), 3 (9x9, default), 4 (16x16) or 5 (25x25)" << endl;
+	cerr << "  --bank FILE     --generate makes random symmetries of the unique puzzles in FILE instead of searching (9x9 only)" << endl;
+	cerr << "  --budget MS     time limit for each puzzle of --generate and --solve; generation settles for the fewest" << endl;
+	cerr << "                  starting squares it reached that still have one solution, and solving gives an empty line" << endl;
+	cerr << "  --node-budget N search node limit for each puzzle, like --budget" << endl;
+}
+
+// function to run the non-interactive modes selected on the command line (returns the exit code)
+int batchMain(int argc, char* argv[])
+{
+	string mode;
+	vector<string> arguments;
+	int numThreads = (int)thread::hardware_concurrency();
+	unsigned long long seed = (unsigned long long)time(NULL);
+	bool seedGiven = false;
+	string outputFile;
+	string bankFile;
+	int boxSize = 3;
+
+	// parse the arguments
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc) numThreads = atoi(argv[++i]);
+		else if (arg == "--seed" && i + 1 < argc)
+		{
+			seed = strtoull(argv[++i], NULL, 10);
+			seedGiven = true;
+		}
+		else if (arg == "--output" && i + 1 < argc) outputFile = argv[++i];
+		else if (arg == "--size" && i + 1 < argc) boxSize = atoi(argv[++i]);
+		else if (arg == "--bank" && i + 1 < argc) bankFile = argv[++i];
+		else if (arg == "--budget" && i + 1 < argc) puzzleMillis = atof(argv[++i]);
+		else if (arg == "--node-budget" && i + 1 < argc) puzzleNodes = atoll(argv[++i]);
+		else if (arg.substr(0, 2) == "--" && mode.empty()) mode = arg;
+		else if (arg.substr(0, 2) != "--") arguments.push_back(arg);
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+	if (numThreads < 1) numThreads = 1;
+
+	// look up the functions for the board size
+	const BoardFormat* format = NULL;
+	for (const BoardFormat& candidate : BOARD_FORMATS)
+		if (candidate.boxSize == boxSize) format = &candidate;
+	if (!format)
+	{
+		usage();
+		return 2;
+	}
+
+	// open the output file if one was given
+	ofstream fout;
+	if (!outputFile.empty())
+	{
+		fout.open(outputFile, ios::binary);
+		if (fout.fail())
+		{
+			cerr << "Could not open " << outputFile << endl;
+			return 1;
+		}
+	}
+	ostream& out = outputFile.empty() ? cout : fout;
+
+	if (mode == "--generate" && arguments.size() == 2)
+	{
+		long long count = atoll(arguments[0].c_str());
+		if (count < 0 || numClues(arguments[1]) == 0)
+		{
+			usage();
+			return 2;
+		}
+
+		// a bank replaces the search with symmetries of its puzzles
+		PuzzleMaker make = format->make;
+		if (!bankFile.empty())
+		{
+			int numBanked = boxSize == 3 ? loadBank(bankFile) : -1;
+			if (numBanked < 0)
+			{
+				cerr << "Could not open " << bankFile << " as a bank of 9x9 puzzles" << endl;
+				return 1;
+			}
+			if (puzzleBank[arguments[1]].empty())
+			{
+				cerr << bankFile << " has no unique " << arguments[1] << " puzzles" << endl;
+				return 1;
+			}
+			cerr << "Loaded " << puzzleBank[arguments[1]].size() << " " << arguments[1] << " puzzles from " << bankFile << endl;
+			make = bankPuzzleLine;
+		}
+
+		auto start = chrono::steady_clock::now();
+		long long written = generateBatch(count, arguments[1], make, numThreads, seed, out);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		cerr << "Generated " << written << " " << arguments[1] << " puzzles in " << seconds << " s on " << numThreads
+			<< " threads (" << (seconds > 0 ? written / seconds : 0) << " puzzles/s)" << endl;
+		if (written < count) cerr << count - written << " ran out of their budget before a square could be removed" << endl;
+		printStats(cerr, currentStats());
+		return 0;
+	}
+
+	if (mode == "--solve" && arguments.size() <= 1)
+	{
+		// read from the file if one was given, otherwise from stdin
+		ifstream fin;
+		if (arguments.size() == 1)
+		{
+			fin.open(arguments[0], ios::binary);
+			if (fin.fail())
+			{
+				cerr << "Could not open " << arguments[0] << endl;
+				return 1;
+			}
+		}
+		istream& in = arguments.size() == 1 ? fin : cin;
+
+		long long numSolved = 0;
+		long long numPuzzles = 0;
+		auto start = chrono::steady_clock::now();
+
+		// files made of fixed size records are memory mapped and split across threads
+		Corpus corpus;
+		if (arguments.size() == 1 && openCorpus(arguments[0], format->lineLength, corpus))
+		{
+			numPuzzles = (long long)corpus.numRecords;
+			numSolved = solveCorpus(corpus, format->solve, numThreads, out);
+			closeCorpus(corpus);
+		}
+		else numPuzzles = solveStream(in, out, format->solve, numSolved);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		cerr << "Solved " << numSolved << " of " << numPuzzles << " puzzles in " << seconds << " s ("
+			<< (seconds > 0 ? numPuzzles / seconds : 0) << " puzzles/s)" << endl;
+		printStats(cerr, currentStats());
+		return numSolved == numPuzzles ? 0 : 1;
+	}
+
+	if (mode == "--validate" && arguments.size() == 1)
+	{
+		Corpus corpus;
+		if (!openCorpus(arguments[0], format->lineLength, corpus))
+		{
+			cerr << "Could not map " << arguments[0] << " (it must hold " << format->lineLength << " character lines only)" << endl;
+			return 1;
+		}
+
+		auto start = chrono::steady_clock::now();
+		long long numValid = validateCorpus(corpus, format->check, numThreads, out);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		long long numBoards = (long long)corpus.numRecords;
+		closeCorpus(corpus);
+
+		cerr << numValid << " of " << numBoards << " boards are correct solutions (checked in " << seconds << " s, "
+			<< (seconds > 0 ? numBoards / seconds : 0) << " boards/s)" << endl;
+		return numValid == numBoards ? 0 : 1;
+	}
+
+	if (mode == "--dedup" && arguments.size() <= 1 && boxSize == 3)
+	{
+		ifstream fin;
+		if (arguments.size() == 1)
+		{
+			fin.open(arguments[0], ios::binary);
+			if (fin.fail())
+			{
+				cerr << "Could not open " << arguments[0] << endl;
+				return 1;
+			}
+		}
+		istream& in = arguments.size() == 1 ? fin : cin;
+
+		// the stream solver hands the lines over in groups, and dedupLines() writes the new ones
+		long long numKept = 0;
+		auto start = chrono::steady_clock::now();
+		long long numPuzzles = solveStream(in, out, dedupLines, numKept);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		cerr << "Kept " << numKept << " of " << numPuzzles << " puzzles in " << seconds << " s ("
+			<< (seconds > 0 ? numPuzzles / seconds : 0) << " puzzles/s)" << endl;
+		return 0;
+	}
+
+	if (mode == "--rate" && arguments.size() <= 1 && boxSize == 3)
+	{
+		ifstream fin;
+		if (arguments.size() == 1)
+		{
+			fin.open(arguments[0], ios::binary);
+			if (fin.fail())
+			{
+				cerr << "Could not open " << arguments[0] << endl;
+				return 1;
+			}
+		}
+		istream& in = arguments.size() == 1 ? fin : cin;
+
+		long long numRated = 0;
+		auto start = chrono::steady_clock::now();
+		long long numPuzzles = solveStream(in, out, rateLines, numRated);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		cerr << "Rated " << numRated << " of " << numPuzzles << " puzzles in " << seconds << " s ("
+			<< (seconds > 0 ? numPuzzles / seconds : 0) << " puzzles/s)" << endl;
+		return numRated == numPuzzles ? 0 : 1;
+	}
+
+	if (mode == "--bench" && arguments.empty())
+	{
+		// fixed seed by default, so that runs can be compared
+		if (!seedGiven) seed = 12345;
+		runBenchmarks(out, seed);
+		return 0;
+	}
+
+	usage();
+	return 2;
+}
+
 // main function
-int main()
+int main(int argc, char* argv[])
 {
+	// any command line arguments select one of the batch modes instead of the game
+	if (argc > 1)
+	{
+		ios::sync_with_stdio(false);
+		return batchMain(argc, argv);
+	}
+
 	// seed the random number generator
-	srand(time(NULL));
+	seedRandom(time(NULL));
 
-	// register the signal handler
+	// register the signal handler (without restarting reads, so a waiting prompt returns right away)
+#ifdef _WIN32
 	signal(SIGINT, signalHandler);
 	signal(SIGTERM, signalHandler);
-#ifdef _WIN32
 	signal(SIGBREAK, signalHandler);
+#else
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = signalHandler;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
 #endif
 
 	// stringstream object for writing data to the console on future iterations of the game loop
 	stringstream console;
 
-	// load the file directory
-	ifstream fin("directory.txt");
-	if (!fin.fail())
-	{
-		fin >> numSaves;
-		
-		// allocate memory for savedGames
-		savedGames = new string[numSaves];
-
-		// read savedGames from the directory
-		for (int i = 0; i < numSaves; ++i)
-			fin >> savedGames[i];
-	}
-	fin.close();
-
-	// alphebetize directory (for redundency)
-	alphebetize(savedGames, numSaves);
+	// open the save store (copying in the save files of older versions when there isn't one yet), and list its games
+	bool storeExists = !ifstream(SAVE_STORE_FILE).fail();
+	if (!openSaveStore(SAVE_STORE_FILE)) cerr << "Could not open " << SAVE_STORE_FILE << "; games will not be saved" << endl;
+	else if (!storeExists) importSaveFiles();
+	listStoredSaves();
 
 	// the game loop will run while running is true
 	bool running = true;
 
-	// load the autosave file
-	load("autosave.txt", board);
-	push(board);
+	// load the autosave (keeping the initial board if there isn't one)
+	fromLine(INITIAL_BOARD, 81, board);
+	loadGame(AUTOSAVE_NAME, board);
+	resetHistory(board);
+
+	// load the solution cache and the puzzle bank
+	loadSolutions(SOLUTION_CACHE_FILE);
+	loadBank(PUZZLE_BANK_FILE);
+
+	// start generating puzzles in the background (beginning with the ones saved last time)
+	loadReady(READY_FILE);
+	startProducer((unsigned long long)time(NULL) ^ 0xA24BAED4963EE407ull);
 
 	// game loop
 	bool menuCommand = true;
@@ -685,7 +5547,7 @@ int main()
 			cout << endl << "Enter a command: ";
 
 			// get user input
-			getline(cin, command);
+			if (!readInput(command)) command = "exit";
 		}
 
 		// process user input
@@ -697,7 +5559,9 @@ int main()
 			
 			if (isLegal(board, x, y, value))
 			{
-				board[x][y] = value;
+				// whatever is set is the player's own entry
+				board.cells[squareIndex(x, y)] = (uint8_t)value;
+				setGiven(board, squareIndex(x, y), false);
 				push(board);
 			}
 			else
@@ -713,15 +5577,14 @@ int main()
 				string filename = command.substr(4);
 				// delete spaces
 				while (filename.length() > 0 && filename[0] == ' ') filename.erase(0, 1);
-				// load from the file
-				load(filename, board);
-				
-				// reset the board stack
-				stackIndex = 0;
-				push(board);
+				// load the game
+				loadGame(filename, board);
+
+				// start a new undo history
+				resetHistory(board);
 			}
-			// otherwise, use default file
-			else load("default.txt", board);
+			// otherwise, use the default save
+			else loadGame(DEFAULT_SAVE_NAME, board);
 		}
 		if (command.substr(0, 4) == "save")
 		{
@@ -731,46 +5594,19 @@ int main()
 				string filename = command.substr(4);
 				// delete spaces
 				while (filename.length() > 0 && filename[0] == ' ') filename.erase(0, 1);
-				// load from the file
-				save(filename, board);
-
-				// check if the save is already in the directory
-				bool inDirectory = false;
-				for (int i = 0; i < numSaves; ++i)
-					if (savedGames[i] == filename) inDirectory = true;
-
-				// add the filename to directory
-				if (!inDirectory)
-				{
-					// allocate additional memory for savedGames
-					string* temp = new string[numSaves];
-					for (int i = 0; i < numSaves; ++i) temp[i] = savedGames[i];
-					if (savedGames) delete[] savedGames;
-					savedGames = new string[numSaves + 1];
-					for (int i = 0; i < numSaves; ++i) savedGames[i] = temp[i];
-					if (temp)
-					{
-						delete[] temp;
-						temp = NULL;
-					}
-
-					// add the filename to the directory
-					savedGames[numSaves] = filename;
-					++numSaves;
-				}
-
-				// re-alphebetize the directory
-				alphebetize(savedGames, numSaves);
+				// save the game, and add the filename to the directory (it stays in alphabetical order)
+				if (storeSave(filename, board)) addSave(filename);
+				else console << "Could not save the game as " << filename << "!" << endl;
 			}
-			// otherwise, use default file
-			else save("default.txt", board);
+			// otherwise, use the default save
+			else if (!storeSave(DEFAULT_SAVE_NAME, board)) console << "Could not save the game!" << endl;
 		}
 		if (command == "list saves")
 		{
 			console << "Saved Games: " << endl;
 			// list contents of the directory
-			for (int i = 0; i < numSaves; ++i)
-				console << "\t" << savedGames[i] << endl;
+			for (const SavedName& entry : savedGames)
+				console << "\t" << savedName(entry) << endl;
 		}
 		if (command.substr(0, 6) == "delete")
 		{
@@ -781,106 +5617,208 @@ int main()
 				// delete leading spaces
 				while (filename.length() > 0 && filename[0] == ' ')
 					filename.erase(0, 1);
-				// remove filename from the directory
-				for (int i = 0; i < numSaves; ++i)
-				{
-					if (savedGames[i] == filename)
-					{
-						for (int j = i + 1; j < numSaves; ++j)
-							savedGames[j - 1] = savedGames[j];
-						--numSaves;
-					}
-				}
-				// delete file from the hard drive
-				remove(filename.c_str());
+				// delete the game from the save store, and remove filename from the directory
+				if (!hasSave(filename)) console << "There is no saved game called " << filename << "!" << endl;
+				else if (storeDelete(filename)) removeSave(filename);
+				else console << "Could not delete " << filename << "!" << endl;
 			}
 		}
 		if (command == "solve")
 		{
-			reset(board);
-			if(!solve(board))
+			long long nodesBefore = currentStats().nodes;
+			auto start = chrono::steady_clock::now();
+			Board solution;
+			bool solved = false;
+			bool cached = findCached(board, solution, solved);
+
+			// the single threaded mrv search runs in time slices, so a long solve can be continued with another "solve"
+			bool paused = false;
+			if (!cached)
+			{
+				if (strategy == MRV && solverThreads == 1) paused = solveSlice(board, solution, solved) == SEARCH_SUSPENDED;
+				else solved = solveAndCache(board, solution);
+			}
+			double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+			if (paused)
+			{
+				console << "Still searching after " << ms << " ms (" << pausedSearch.nodes << " nodes so far); enter \"solve\" again to continue" << endl;
+				continue;
+			}
+			if (solved) board = solution;
+			else
+			{
+				reset(board);
 				console << "No solutions found!";
+			}
+			if (cached) console << "Solved from the cache in " << ms << " ms" << endl;
+			else console << "Solved with the " << strategyName(strategy) << " strategy in " << ms << " ms (" << currentStats().nodes - nodesBefore << " nodes)" << endl;
 			push(board);
 		}
+		if (command.substr(0, 8) == "strategy")
+		{
+			// select the search strategy by name
+			if (command.length() > 9)
+			{
+				string name = command.substr(9);
+				if (name == "naive") strategy = NAIVE;
+				else if (name == "bitmask") strategy = BITMASK;
+				else if (name == "mrv") strategy = MRV;
+				else if (name == "dlx") strategy = DANCING_LINKS;
+				else console << "Unknown strategy! Available strategies are \"naive\" \"bitmask\" \"mrv\" and \"dlx.\"" << endl;
+			}
+			console << "Current strategy: " << strategyName(strategy) << endl;
+		}
+		if (command == "stats")
+		{
+			printStats(console, currentStats());
+		}
+		if (command.substr(0, 5) == "cache")
+		{
+			if (command == "cache clear")
+			{
+				clearSolutions();
+				console << "Solution cache cleared" << endl;
+			}
+			else if (command == "cache persist on") persistSolutions = true;
+			else if (command == "cache persist off")
+			{
+				// stop saving the cache and delete the saved one
+				persistSolutions = false;
+				remove(SOLUTION_CACHE_FILE);
+			}
+			console << "Solution cache: " << solutionCache.size() << " of " << SOLUTION_CACHE_SIZE << " puzzles, " << cacheHits << " hits, " << cacheMisses << " misses";
+			console << (persistSolutions ? " (saved on exit)" : " (not saved)") << endl;
+		}
+		if (command.substr(0, 6) == "pregen")
+		{
+			if (command == "pregen persist on") persistReady = true;
+			else if (command == "pregen persist off")
+			{
+				// stop saving the ready puzzles and delete the saved ones
+				persistReady = false;
+				remove(READY_FILE);
+			}
+			console << "Ready puzzles:";
+			for (int i = 0; i < 3; ++i)
+				console << " " << readyCount(readyQueues[i]) << " " << READY_DIFFICULTIES[i];
+			console << (persistReady ? " (saved on exit)" : " (not saved)") << endl;
+		}
+		if (command == "rate")
+		{
+			// rate the puzzle by the techniques it needs
+			Rating rating = ratePuzzle(board);
+			console << "This puzzle needs " << TECHNIQUE_NAMES[rating.hardest] << " (" << rating.steps << " steps), so it is "
+				<< ratingDifficulty(rating) << endl;
+		}
+		if (command == "stats reset")
+		{
+			resetStats();
+			console << "Statistics cleared" << endl;
+		}
+		if (command.substr(0, 7) == "threads")
+		{
+			// set the number of threads the solver may use
+			if (command.length() > 8)
+			{
+				int numThreads = atoi(command.substr(8).c_str());
+				if (numThreads >= 1) solverThreads = numThreads;
+				else console << "The number of threads must be at least 1!" << endl;
+			}
+			console << "The solver uses " << solverThreads << " thread" << (solverThreads == 1 ? "" : "s") << endl;
+		}
+		if (command == "benchmark")
+		{
+			// solve the current puzzle with every strategy and compare nodes visited and wall time
+			Strategy current = strategy;
+			Strategy strategies[4] = { NAIVE, BITMASK, MRV, DANCING_LINKS };
+			for (int i = 0; i < 4; ++i)
+			{
+				Board temp = board;
+				reset(temp);
+
+				strategy = strategies[i];
+				long long nodesBefore = currentStats().nodes;
+				auto start = chrono::steady_clock::now();
+				bool solved = solve(temp);
+				double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+				console << strategyName(strategy) << ": " << (solved ? "solved" : "no solution") << " in " << ms << " ms (" << currentStats().nodes - nodesBefore << " nodes)" << endl;
+			}
+			strategy = current;
+		}
 		if (command.substr(0, 4) == "hint")
 		{
 			int y = command[5] - 'a';
 			int x = command[6] - '1';
 
-			// copy board into a temporary array
-			int temp[9][9];
-			for (int x = 0; x < 9; ++x)
-				for (int y = 0; y < 9; ++y)
-					temp[x][y] = board[x][y];
-
-			// solve the temp board
-			reset(temp);
-			solve(temp);
+			// look up (or find) the solution of the puzzle
+			Board solution;
+			if (!cachedSolve(board, solution))
+			{
+				console << "No solutions found!" << endl;
+				continue;
+			}
 
 			// give the hint to the user
-			console << "The value of square " << char(y + 'a') << char(x + '1') << " is " << temp[x][y] << endl;
+			console << "The value of square " << char(y + 'a') << char(x + '1') << " is " << (int)solution.cells[squareIndex(x, y)] << endl;
 		}
 		if (command.substr(0, 3) == "new")
 		{
-			// clear the board
-			for (int x = 0; x < 9; ++x)
-				for (int y = 0; y < 9; ++y)
-					board[x][y] = 0;
-
-			// generate a new puzzle
-			randFill(board);
-			if (command.substr(4) == "easy") generate(board, 35 + rand() % 5);
-			if (command.substr(4) == "medium") generate(board, 30 + rand() % 5);
-			if (command.substr(4) == "hard") generate(board, 25 + rand() % 5);
-
-			// flip signs to denote starting squares
-			for (int x = 0; x < 9; ++x)
-				for (int y = 0; y < 9; ++y)
-					board[x][y] = -board[x][y];
+			// take a puzzle the background producer has ready, or else transform one from the bank, or else generate one here
+			// within NEW_PUZZLE_MS (new puzzles are added to the bank)
+			string difficulty = command.length() > 4 ? command.substr(4) : "";
+			ReadyQueue* queue = readyQueue(difficulty);
+			if (!queue)
+			{
+				console << "Unknown difficulty! Available difficulties are \"easy\" \"medium\" and \"hard.\"" << endl;
+				continue;
+			}
+			if (popReady(*queue, board)) addToBank(board);
+			else if (!bankPuzzle(board, difficulty))
+			{
+				// generate on the side, so the board is kept if the time runs out first
+				Board puzzle;
+				if (!newPuzzle(puzzle, difficulty, makeBudget(NEW_PUZZLE_MS, 0)))
+				{
+					console << "Could not make a puzzle in time! Please try again." << endl;
+					continue;
+				}
+				board = puzzle;
+				addToBank(board);
+			}
 
-			// reset the board stack
-			stackIndex = 0;
-			push(board);
+			// start a new undo history
+			resetHistory(board);
 		}
 		if (command == "menu")
 		{
 			menuCommand = true;
 		}
-		if (command == "undo" && stackIndex > 1)
+		if (command.substr(0, 4) == "undo")
 		{
-			--stackIndex;
-			for (int x = 0; x < 9; ++x)
-				for (int y = 0; y < 9; ++y)
-					board[x][y] = boardStack[x][y][stackIndex - 1];
+			// undo one move, or as many as the user asked for
+			int steps = command.length() > 5 ? atoi(command.substr(5).c_str()) : 1;
+			if (steps > 0) jumpTo(board, historyIndex - steps);
 		}
-		if (command == "redo" && stackIndex < maxIndex)
+		if (command.substr(0, 4) == "redo")
 		{
-			for (int x = 0; x < 9; ++x)
-				for (int y = 0; y < 9; ++y)
-					board[x][y] = boardStack[x][y][stackIndex];
-			++stackIndex;
+			int steps = command.length() > 5 ? atoi(command.substr(5).c_str()) : 1;
+			if (steps > 0) jumpTo(board, historyIndex + steps);
 		}
 		if (command == "exit")
 		{
 			// this code executes if the command entered by the user is "exit"
-			save("autosave.txt", board); // save the board to an autosave file
+			if (!storeSave(AUTOSAVE_NAME, board)) cerr << "Could not save the game!" << endl; // save the board to the autosave
+			if (persistSolutions) saveSolutions(SOLUTION_CACHE_FILE);
+			if (bankChanged) saveBank(PUZZLE_BANK_FILE);
+			stopProducerThread();
+			if (persistReady) saveReady(READY_FILE);
 			running = false; // now, the loop will exit after it is done running this iteration
-
-			// save contents of the directory
-			ofstream fout("directory.txt");
-			fout << numSaves << endl;
-			for (int i = 0; i < numSaves; ++i)
-				fout << savedGames[i] << endl;
-			fout.close();
 		}
 	}
 
-	// deallocate savedGames memory
-	if (savedGames)
-	{
-		delete[] savedGames;
-		savedGames = NULL;
-	}
+	closeSaveStore();
 
 	// end program
 	return 0;